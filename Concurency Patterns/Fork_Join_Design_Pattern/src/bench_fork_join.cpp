@@ -0,0 +1,327 @@
+/*
+
+Benchmark of parallel_sum
+
+The same recursive split of parallel.cpp, run with three launch policies:
+
+async    : both halves of every split in std::async(std::launch::async), as in the
+           original example. Starts two threads per split, the thread count is
+           not a parameter.
+deferred : std::async(std::launch::deferred). Nothing runs in parallel, this
+           measures the cost of the futures alone.
+pool     : parallel_reduce on a ForkJoinPool of the given size, splitting down to
+           the same grain (SimplePartitioner).
+
+Every policy uses the same leaf (simd::sum). Arguments are the input size, the
+grain (largest range summed without splitting) and, for the pool, the number of
+worker threads. Besides time, each run reports:
+
+ns/elem        : time per element
+GB/s           : bytes of input read per second
+vs_accumulate  : speedup over std::accumulate on one thread
+vs_reduce_par  : speedup over std::reduce(std::execution::par) with the same
+                 number of threads (all hardware threads for async/deferred)
+
+std::reduce(par) needs the TBB backend of libstdc++ to run in parallel; without
+TBB it runs on the calling thread.
+
+Run with --benchmark_filter=pool to select one policy.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <future>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "partitioner.hpp"
+#include "simd_reduce.hpp"
+
+#ifdef FORK_JOIN_HAVE_TBB
+#include <tbb/global_control.h>
+#endif
+
+namespace
+{
+
+enum class Policy
+{
+    Async,
+    Deferred,
+    Pool
+};
+
+const std::size_t max_size = std::size_t(1) << 24;
+
+// Input shared by every benchmark, not all ones so that a wrong split shows in the result
+const std::vector<int>& input()
+{
+    static const std::vector<int> arr = []
+    {
+        std::vector<int> values(max_size);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = static_cast<int>(i % 7);
+        }
+        return values;
+    }();
+    return arr;
+}
+
+std::size_t hardware_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Pools are created once per thread count, so that starting threads is not measured
+ForkJoinPool& pool_of(std::size_t threads)
+{
+    static std::map<std::size_t, std::unique_ptr<ForkJoinPool>> pools;
+    std::unique_ptr<ForkJoinPool>& pool = pools[threads];
+    if (!pool)
+    {
+        pool = std::make_unique<ForkJoinPool>(threads);
+    }
+    return *pool;
+}
+
+std::int64_t async_sum(const int* arr, std::size_t start, std::size_t end, std::size_t grain, std::launch policy)
+{
+    // Base case: if the range is small, compute directly
+    if (end - start <= grain)
+    {
+        return simd::sum(arr + start, end - start);
+    }
+
+    // Recursive case: split the range and compute each half in its own task
+    std::size_t mid = start + (end - start) / 2;
+    auto left_future = std::async(policy, async_sum, arr, start, mid, grain, policy);
+    auto right_future = std::async(policy, async_sum, arr, mid, end, grain, policy);
+
+    // Join: wait for both halves to complete and combine results
+    return left_future.get() + right_future.get();
+}
+
+std::int64_t pool_sum(ForkJoinPool& pool, const int* arr, std::size_t size, std::size_t grain)
+{
+    return parallel_reduce(pool, 0, size, std::int64_t(0),
+        [arr](std::size_t first, std::size_t last) { return simd::sum(arr + first, last - first); },
+        [](std::int64_t left, std::int64_t right) { return left + right; },
+        SimplePartitioner(grain));
+}
+
+std::int64_t accumulate_sum(const int* arr, std::size_t size)
+{
+    return std::accumulate(arr, arr + size, std::int64_t(0));
+}
+
+// Caps the threads std::reduce(par) uses while alive. Reconfiguring the TBB arena is
+// not cheap, so it is set up once around a measurement, not inside the timed call.
+class ParallelismLimit
+{
+public:
+    explicit ParallelismLimit(std::size_t threads)
+#ifdef FORK_JOIN_HAVE_TBB
+        : limit(tbb::global_control::max_allowed_parallelism, threads)
+#endif
+    {
+        (void)threads;
+    }
+
+private:
+#ifdef FORK_JOIN_HAVE_TBB
+    tbb::global_control limit;
+#endif
+};
+
+std::int64_t reduce_par_sum(const int* arr, std::size_t size)
+{
+    return std::reduce(std::execution::par, arr, arr + size, std::int64_t(0));
+}
+
+// Time of one call: best mean over 10 batches of at least 10 ms each
+template <typename F>
+double best_ns(F f)
+{
+    using clock = std::chrono::steady_clock;
+
+    double best = 0;
+    for (int batch = 0; batch < 10; ++batch)
+    {
+        std::size_t calls = 0;
+        clock::time_point start = clock::now();
+        clock::duration elapsed{};
+        do
+        {
+            benchmark::DoNotOptimize(f());
+            ++calls;
+            elapsed = clock::now() - start;
+        } while (elapsed < std::chrono::milliseconds(10));
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+        if (batch == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+// Baseline times, measured once per size (and thread count)
+double accumulate_ns(std::size_t size)
+{
+    static std::map<std::size_t, double> times;
+    auto it = times.find(size);
+    if (it == times.end())
+    {
+        it = times.emplace(size, best_ns([size] { return accumulate_sum(input().data(), size); })).first;
+    }
+    return it->second;
+}
+
+double reduce_par_ns(std::size_t size, std::size_t threads)
+{
+    static std::map<std::pair<std::size_t, std::size_t>, double> times;
+    auto it = times.find({size, threads});
+    if (it == times.end())
+    {
+        ParallelismLimit limit(threads);
+        it = times.emplace(std::make_pair(size, threads), best_ns([size] { return reduce_par_sum(input().data(), size); })).first;
+    }
+    return it->second;
+}
+
+void set_counters(benchmark::State& state, std::size_t size, std::size_t threads, double ns_per_call)
+{
+    state.counters["ns/elem"] = ns_per_call / size;
+    state.counters["GB/s"] = size * sizeof(int) / ns_per_call;
+    state.counters["vs_accumulate"] = accumulate_ns(size) / ns_per_call;
+    state.counters["vs_reduce_par"] = reduce_par_ns(size, threads) / ns_per_call;
+}
+
+// Runs `sum` in the benchmark loop and records the counters
+template <typename Sum>
+void run(benchmark::State& state, std::size_t size, std::size_t threads, Sum sum)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::int64_t expected = accumulate_sum(input().data(), size);
+    clock::time_point start = clock::now();
+    for (auto _ : state)
+    {
+        std::int64_t result = sum();
+        benchmark::DoNotOptimize(result);
+        if (result != expected)
+        {
+            state.SkipWithError("wrong sum");
+            return;
+        }
+    }
+    double ns_per_call = std::chrono::duration<double, std::nano>(clock::now() - start).count() / state.iterations();
+
+    set_counters(state, size, threads, ns_per_call);
+}
+
+void BM_parallel_sum(benchmark::State& state, Policy policy)
+{
+    std::size_t size = static_cast<std::size_t>(state.range(0));
+    std::size_t grain = static_cast<std::size_t>(state.range(1));
+    const int* arr = input().data();
+
+    if (policy == Policy::Pool)
+    {
+        std::size_t threads = static_cast<std::size_t>(state.range(2));
+        ForkJoinPool& pool = pool_of(threads);
+        run(state, size, threads, [&] { return pool_sum(pool, arr, size, grain); });
+    }
+    else
+    {
+        std::launch launch = policy == Policy::Async ? std::launch::async : std::launch::deferred;
+        run(state, size, hardware_threads(), [&] { return async_sum(arr, 0, size, grain, launch); });
+    }
+}
+
+void BM_accumulate(benchmark::State& state)
+{
+    std::size_t size = static_cast<std::size_t>(state.range(0));
+    run(state, size, 1, [&] { return accumulate_sum(input().data(), size); });
+}
+
+void BM_reduce_par(benchmark::State& state)
+{
+    std::size_t size = static_cast<std::size_t>(state.range(0));
+    std::size_t threads = static_cast<std::size_t>(state.range(1));
+    ParallelismLimit limit(threads);
+    run(state, size, threads, [&] { return reduce_par_sum(input().data(), size); });
+}
+
+const std::vector<std::int64_t> sizes = {1 << 16, 1 << 20, 1 << 24};
+const std::vector<std::int64_t> grains = {1 << 10, 1 << 13, 1 << 16};
+
+std::vector<std::int64_t> thread_counts()
+{
+    std::vector<std::int64_t> counts;
+    for (std::size_t t = 1; t < hardware_threads(); t *= 2)
+    {
+        counts.push_back(static_cast<std::int64_t>(t));
+    }
+    counts.push_back(static_cast<std::int64_t>(hardware_threads()));
+    return counts;
+}
+
+// std::async starts two threads per split: keep the number of leaves (and threads) reasonable
+const std::int64_t max_async_leaves = 4096;
+
+void async_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"size", "grain"});
+    for (std::int64_t size : sizes)
+    {
+        for (std::int64_t grain : grains)
+        {
+            if (size / grain <= max_async_leaves) b->Args({size, grain});
+        }
+    }
+}
+
+void pool_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"size", "grain", "threads"});
+    for (std::int64_t size : sizes)
+    {
+        for (std::int64_t grain : grains)
+        {
+            for (std::int64_t threads : thread_counts())
+            {
+                b->Args({size, grain, threads});
+            }
+        }
+    }
+}
+
+void baseline_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"size", "threads"});
+    for (std::int64_t size : sizes)
+    {
+        for (std::int64_t threads : thread_counts())
+        {
+            b->Args({size, threads});
+        }
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_accumulate)->ArgName("size")->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->UseRealTime();
+BENCHMARK(BM_reduce_par)->Apply(baseline_args)->UseRealTime();
+BENCHMARK_CAPTURE(BM_parallel_sum, async, Policy::Async)->Apply(async_args)->UseRealTime();
+BENCHMARK_CAPTURE(BM_parallel_sum, deferred, Policy::Deferred)->Apply(async_args)->UseRealTime();
+BENCHMARK_CAPTURE(BM_parallel_sum, pool, Policy::Pool)->Apply(pool_args)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,156 @@
+/*
+
+Benchmark of Future::then
+
+Every iteration makes a Promise<int>, attaches a continuation to its future,
+sets the value and reads the result.
+
+BM_then       : a continuation that captures nothing.
+BM_then_large : a continuation capturing 128 bytes, more than the inline buffer
+                of detail::Callback.
+BM_then_via   : like BM_then, after via() on an executor that runs tasks
+                inline and takes move-only tasks.
+BM_std_async  : the same step with std::async(std::launch::deferred) on a
+                std::future, for reference.
+
+Reports allocs/then, the number of calls to the global operator new made by the
+then() call alone. A small continuation must only allocate the shared state of
+its result (1); BM_then and BM_then_via fail if it does more.
+
+*/
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <utility>
+#include <benchmark/benchmark.h>
+#include "future.hpp"
+
+namespace
+{
+
+std::atomic<std::int64_t> allocations{0};
+
+} // namespace
+
+// Every call is counted for allocs/then
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+struct InlineExecutor
+{
+    static constexpr bool move_only_tasks = true;
+
+    template <typename F>
+    void submit(F&& f)
+    {
+        f();
+    }
+};
+
+void report(benchmark::State& state, std::int64_t then_allocs, double limit)
+{
+    double per_then = static_cast<double>(then_allocs) / static_cast<double>(state.iterations());
+    state.counters["allocs/then"] = per_then;
+    if (per_then > limit) state.SkipWithError("a small continuation was allocated");
+}
+
+void BM_then(benchmark::State& state)
+{
+    std::int64_t then_allocs = 0;
+    int i = 0;
+    for (auto _ : state)
+    {
+        Promise<int> promise;
+        Future<int> future = promise.get_future();
+
+        std::int64_t before = allocations.load(std::memory_order_relaxed);
+        Future<int> next = std::move(future).then([](int x) { return x + 1; });
+        then_allocs += allocations.load(std::memory_order_relaxed) - before;
+
+        promise.set_value(i++);
+        benchmark::DoNotOptimize(next.get());
+    }
+    report(state, then_allocs, 1.0);
+}
+
+void BM_then_large(benchmark::State& state)
+{
+    std::array<std::int64_t, 16> payload{};
+    std::int64_t then_allocs = 0;
+    int i = 0;
+    for (auto _ : state)
+    {
+        Promise<int> promise;
+        Future<int> future = promise.get_future();
+
+        std::int64_t before = allocations.load(std::memory_order_relaxed);
+        Future<std::int64_t> next = std::move(future).then([payload](int x) { return payload[0] + x; });
+        then_allocs += allocations.load(std::memory_order_relaxed) - before;
+
+        promise.set_value(i++);
+        benchmark::DoNotOptimize(next.get());
+    }
+    report(state, then_allocs, 2.0);
+}
+
+void BM_then_via(benchmark::State& state)
+{
+    InlineExecutor executor;
+    std::int64_t then_allocs = 0;
+    int i = 0;
+    for (auto _ : state)
+    {
+        Promise<int> promise;
+        Future<int> future = promise.get_future().via(executor);
+
+        std::int64_t before = allocations.load(std::memory_order_relaxed);
+        Future<int> next = std::move(future).then([](int x) { return x + 1; });
+        then_allocs += allocations.load(std::memory_order_relaxed) - before;
+
+        promise.set_value(i++);
+        benchmark::DoNotOptimize(next.get());
+    }
+    report(state, then_allocs, 1.0);
+}
+
+void BM_std_async(benchmark::State& state)
+{
+    std::int64_t then_allocs = 0;
+    int i = 0;
+    for (auto _ : state)
+    {
+        std::promise<int> promise;
+        std::future<int> future = promise.get_future();
+
+        std::int64_t before = allocations.load(std::memory_order_relaxed);
+        std::future<int> next = std::async(std::launch::deferred, [f = std::move(future)]() mutable { return f.get() + 1; });
+        then_allocs += allocations.load(std::memory_order_relaxed) - before;
+
+        promise.set_value(i++);
+        benchmark::DoNotOptimize(next.get());
+    }
+    state.counters["allocs/then"] = static_cast<double>(then_allocs) / static_cast<double>(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_then);
+BENCHMARK(BM_then_large);
+BENCHMARK(BM_then_via);
+BENCHMARK(BM_std_async);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,143 @@
+/*
+
+Benchmark of multi-producer / multi-consumer queues
+
+MutexQueue   : std::queue + one mutex + one condition variable, with notify_one()
+               on every push, as in std_async_prod_consumer_condvar.cpp before
+               the sharded queue.
+ShardedQueue : sharded_queue.hpp.
+
+Arguments are the number of producer and consumer threads, from 1 to 64 each.
+The producers push `items` integers in total, the consumers pop until the queue
+is closed and drained. Each run reports items/s over the whole transfer
+(starting the threads included, which the item count keeps small).
+
+*/
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "sharded_queue.hpp"
+
+namespace
+{
+
+// The queue of the original example, with the same interface as ShardedQueue
+template <typename T>
+class MutexQueue
+{
+public:
+    void push(T value)
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        data_queue.push(std::move(value));
+        data_cond.notify_one();
+    }
+
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        data_cond.wait(lock, [this] { return closed || !data_queue.empty(); });
+        if (data_queue.empty()) return std::nullopt;
+
+        T value = std::move(data_queue.front());
+        data_queue.pop();
+        return value;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        closed = true;
+        data_cond.notify_all();
+    }
+
+private:
+    std::queue<T> data_queue;
+    std::mutex queue_mutex;
+    std::condition_variable data_cond;
+    bool closed = false;
+};
+
+const std::int64_t items = 1 << 18;
+
+template <typename Queue>
+void BM_queue(benchmark::State& state)
+{
+    int producers = static_cast<int>(state.range(0));
+    int consumers = static_cast<int>(state.range(1));
+    std::int64_t per_producer = items / producers;
+
+    for (auto _ : state)
+    {
+        Queue queue;
+        std::atomic<std::int64_t> received{0};
+
+        std::vector<std::thread> threads;
+        for (int c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&]
+            {
+                std::int64_t count = 0;
+                while (std::optional<std::int64_t> value = queue.pop())
+                {
+                    benchmark::DoNotOptimize(*value);
+                    ++count;
+                }
+                received.fetch_add(count, std::memory_order_relaxed);
+            });
+        }
+
+        std::vector<std::thread> producer_threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            producer_threads.emplace_back([&queue, per_producer]
+            {
+                for (std::int64_t i = 0; i < per_producer; ++i)
+                {
+                    queue.push(i);
+                }
+            });
+        }
+        for (std::thread& t : producer_threads)
+        {
+            t.join();
+        }
+
+        queue.close();
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+
+        if (received.load() != per_producer * producers)
+        {
+            state.SkipWithError("lost items");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * per_producer * producers);
+}
+
+void thread_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"producers", "consumers"});
+    for (int n = 1; n <= 64; n *= 2)
+    {
+        b->Args({n, n});
+    }
+    b->Args({1, 64});
+    b->Args({64, 1});
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_queue, MutexQueue<std::int64_t>)->Apply(thread_args)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_queue, ShardedQueue<std::int64_t>)->Apply(thread_args)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
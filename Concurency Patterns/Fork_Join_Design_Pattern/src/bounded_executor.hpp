@@ -0,0 +1,191 @@
+/*
+
+Bounded executor with admission control
+
+std::async(std::launch::async, f) starts one OS thread per task. With tens of
+thousands of tasks, most of the time goes into creating threads, and nothing
+limits how many of them run at once.
+
+BoundedExecutor runs tasks on a fixed number of worker threads (the concurrency
+limit) and queues at most `capacity` tasks that have not started yet. When the
+queue is full, submit() applies the overflow policy:
+
+Overflow::Block  : the submitting thread waits until a worker takes a task.
+Overflow::Reject : submit() returns false and the task is dropped.
+Overflow::Inline : the submitting thread runs the task itself, which also slows
+                   the producer down to the speed of the workers.
+
+wait() blocks until every accepted task has finished and rethrows the first
+exception thrown by a task.
+
+Tasks are stored as detail::Callback (callback.hpp): they only need to be
+movable, and a task of up to 64 bytes is not allocated. A rejected task is left
+untouched, so the caller can still run it (move_only_tasks, see future.hpp).
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "callback.hpp"
+
+enum class Overflow
+{
+    Block,
+    Reject,
+    Inline
+};
+
+class BoundedExecutor
+{
+public:
+    BoundedExecutor(std::size_t numThreads, std::size_t capacity_, Overflow overflow_ = Overflow::Block)
+        : capacity(capacity_ ? capacity_ : 1), overflow(overflow_)
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(numThreads, 1); ++i)
+        {
+            workers.emplace_back(&BoundedExecutor::workerThread, this);
+        }
+    }
+
+    ~BoundedExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        not_empty.notify_all();
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    BoundedExecutor(const BoundedExecutor&) = delete;
+    BoundedExecutor& operator=(const BoundedExecutor&) = delete;
+
+    static constexpr bool move_only_tasks = true;
+
+    std::size_t size() const { return workers.size(); }
+
+    // Returns false when the task was rejected (Overflow::Reject and queue full)
+    template <typename F>
+    bool submit(F&& f)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (tasks.size() >= capacity)
+        {
+            switch (overflow)
+            {
+                case Overflow::Reject:
+                    ++rejected;
+                    return false;
+
+                case Overflow::Inline:
+                    ++running;
+                    lock.unlock();
+                    run(detail::Callback(std::forward<F>(f)));
+                    return true;
+
+                case Overflow::Block:
+                    not_full.wait(lock, [this] { return tasks.size() < capacity; });
+                    break;
+            }
+        }
+
+        tasks.emplace_back(std::forward<F>(f));
+        ++running;
+        lock.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    // Waits until every accepted task has finished, then rethrows the first exception
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        idle.wait(lock, [this] { return running == 0; });
+
+        if (error)
+        {
+            std::exception_ptr e = std::exchange(error, nullptr);
+            std::rethrow_exception(e);
+        }
+    }
+
+    // Number of tasks dropped by Overflow::Reject
+    std::size_t rejected_count() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return rejected;
+    }
+
+private:
+    void workerThread()
+    {
+        while (true)
+        {
+            detail::Callback task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                not_empty.wait(lock, [this] { return stop || !tasks.empty(); });
+                if (tasks.empty())
+                {
+                    return; // stop requested and nothing left to run
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            not_full.notify_one();
+
+            run(std::move(task));
+        }
+    }
+
+    // Runs an accepted task and counts it as finished
+    void run(detail::Callback task)
+    {
+        std::exception_ptr e;
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            e = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (e && !error)
+        {
+            error = e;
+        }
+        if (--running == 0)
+        {
+            idle.notify_all();
+        }
+    }
+
+    const std::size_t capacity;
+    const Overflow overflow;
+
+    mutable std::mutex mtx;
+    std::condition_variable not_empty; // workers wait for tasks
+    std::condition_variable not_full;  // Overflow::Block submitters wait for room
+    std::condition_variable idle;      // wait() waits for running == 0
+    std::deque<detail::Callback> tasks;
+    std::size_t running = 0; // accepted and not finished, queued or executing
+    std::size_t rejected = 0;
+    std::exception_ptr error;
+    bool stop = false;
+
+    std::vector<std::thread> workers;
+};
@@ -0,0 +1,117 @@
+/*
+
+Move-only void() callable
+
+std::function requires a copyable callable, so a task that owns a promise or a
+unique_ptr has to be wrapped in a shared_ptr first, and anything larger than two
+pointers goes to the heap. detail::Callback only needs the callable to be
+movable, and stores callables of up to inline_size bytes in place: the
+continuations of future.hpp and the tasks of BoundedExecutor.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace detail
+{
+
+// Move-only void() callable. Callables of up to inline_size bytes are stored in place.
+class Callback
+{
+public:
+    static constexpr std::size_t inline_size = 8 * sizeof(void*);
+
+    Callback() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Callback>>>
+    Callback(F&& f)
+    {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= inline_size && alignof(Fn) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Fn>)
+        {
+            ::new (static_cast<void*>(storage)) Fn(std::forward<F>(f));
+            ops = &inline_ops<Fn>;
+        }
+        else
+        {
+            ::new (static_cast<void*>(storage)) Fn*(new Fn(std::forward<F>(f)));
+            ops = &heap_ops<Fn>;
+        }
+    }
+
+    Callback(Callback&& other) noexcept { take(other); }
+
+    Callback& operator=(Callback&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    Callback(const Callback&) = delete;
+    Callback& operator=(const Callback&) = delete;
+
+    ~Callback() { reset(); }
+
+    explicit operator bool() const { return ops != nullptr; }
+    void operator()() { ops->call(storage); }
+
+private:
+    struct Ops
+    {
+        void (*call)(void*);
+        void (*move)(void* to, void* from); // move-constructs into `to` and destroys `from`
+        void (*destroy)(void*);
+    };
+
+    template <typename Fn>
+    static Fn& object(void* p) { return *std::launder(static_cast<Fn*>(p)); }
+
+    template <typename Fn>
+    static constexpr Ops inline_ops = {
+        [](void* p) { object<Fn>(p)(); },
+        [](void* to, void* from)
+        {
+            ::new (to) Fn(std::move(object<Fn>(from)));
+            object<Fn>(from).~Fn();
+        },
+        [](void* p) { object<Fn>(p).~Fn(); }};
+
+    template <typename Fn>
+    static constexpr Ops heap_ops = {
+        [](void* p) { (*object<Fn*>(p))(); },
+        [](void* to, void* from) { ::new (to) Fn*(object<Fn*>(from)); },
+        [](void* p) { delete object<Fn*>(p); }};
+
+    void take(Callback& other) noexcept
+    {
+        if (other.ops)
+        {
+            other.ops->move(storage, other.storage);
+            ops = std::exchange(other.ops, nullptr);
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (ops)
+        {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[inline_size];
+    const Ops* ops = nullptr;
+};
+
+} // namespace detail
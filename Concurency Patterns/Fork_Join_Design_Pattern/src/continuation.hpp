@@ -0,0 +1,63 @@
+/*
+
+Continuation-passing fork-join
+
+Instead of blocking until its children are done (future.get(), sync()), a
+parent task creates a join point holding a counter and a continuation, hands
+each child a callback into that join point, and returns. The last child to
+arrive runs the continuation, which usually arrives at the parent's own join
+point, so the results flow up the tree without any thread waiting.
+
+    auto* join = make_join<std::int64_t, 2>([k](const std::array<std::int64_t, 2>& r) { k(r[0] + r[1]); });
+    pool.spawn([=] { left(...,  [join](std::int64_t v) { join->arrive(0, v); }); });
+    right(..., [join](std::int64_t v) { join->arrive(1, v); });
+
+Stack use stays bounded by the depth of the recursion: a task returns as soon
+as it has forked, and only the chain of continuations runs on the stack of the
+last arriving child.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Join counter plus continuation, deleted by the last child that arrives
+template <typename T, std::size_t N, typename Continuation>
+class ContinuationJoin
+{
+public:
+    explicit ContinuationJoin(Continuation continuation_) : continuation(std::move(continuation_)) {}
+
+    ContinuationJoin(const ContinuationJoin&) = delete;
+    ContinuationJoin& operator=(const ContinuationJoin&) = delete;
+
+    // Child `slot` delivers its result; the last one runs the continuation
+    void arrive(std::size_t slot, T value)
+    {
+        results[slot] = std::move(value);
+
+        // acq_rel: the last child sees every result written by the others
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            continuation(results);
+            delete this;
+        }
+    }
+
+private:
+    ~ContinuationJoin() = default;
+
+    std::array<T, N> results{};
+    std::atomic<std::size_t> pending{N};
+    Continuation continuation;
+};
+
+template <typename T, std::size_t N, typename Continuation>
+ContinuationJoin<T, N, Continuation>* make_join(Continuation continuation)
+{
+    return new ContinuationJoin<T, N, Continuation>(std::move(continuation));
+}
@@ -0,0 +1,400 @@
+/*
+
+Work-stealing fork-join runtime
+
+A fixed set of worker threads, each owning a Chase-Lev deque of tasks.
+
+spawn(group, f) : pushes f onto the deque of the calling worker (LIFO for the owner).
+sync(group)     : waits until every task spawned into the group has finished.
+                  While waiting, a worker keeps executing tasks (its own first,
+                  then tasks stolen from the top of other workers' deques),
+                  so no thread is ever parked on a join.
+spawn(f)        : detached task, for continuation-passing code (continuation.hpp)
+                  where the last child to finish runs the parent's continuation.
+invoke(f)       : runs f on the pool from an outside thread and returns its result.
+
+parallel_reduce() is built on top of spawn/sync in partitioner.hpp.
+
+No OS thread is created per task: the number of threads is fixed when the pool
+is constructed, whatever the depth of the recursion.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "chase_lev_deque.hpp"
+
+class TaskGroup;
+
+// Unit of work scheduled on the pool
+struct Task
+{
+    TaskGroup* group = nullptr;
+
+    virtual ~Task() = default;
+    virtual void run() = 0;
+};
+
+template <typename F>
+struct FunctionTask : Task
+{
+    F fn;
+
+    explicit FunctionTask(F&& f) : fn(std::move(f)) {}
+    void run() override { fn(); }
+};
+
+// Join counter shared by the tasks spawned together
+class TaskGroup
+{
+public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    bool done() const { return (pending.load(std::memory_order_acquire) & ~waiter_bit) == 0; }
+
+private:
+    friend class ForkJoinPool;
+
+    // Set in pending when a thread outside the pool blocks on the group
+    static constexpr std::size_t waiter_bit = std::size_t(1) << (sizeof(std::size_t) * 8 - 1);
+
+    void add() { pending.fetch_add(1, std::memory_order_relaxed); }
+
+    void finish()
+    {
+        std::size_t previous = pending.fetch_sub(1, std::memory_order_acq_rel);
+        if (previous == (waiter_bit | 1))
+        {
+            // Last task and someone is blocked: the group must not be touched after the unlock
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            released = true;
+            wait_cv.notify_all();
+        }
+    }
+
+    // Leaves the group ready for another round of spawn/sync
+    void wait()
+    {
+        std::size_t previous = pending.fetch_or(waiter_bit, std::memory_order_acq_rel);
+        if (previous == 0)
+        {
+            // Already drained, no finisher will signal us
+            pending.fetch_and(~waiter_bit, std::memory_order_relaxed);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        wait_cv.wait(lock, [this] { return released; });
+        released = false;
+        pending.fetch_and(~waiter_bit, std::memory_order_relaxed);
+    }
+
+    void fail(std::exception_ptr e)
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = e; // Keep the first exception only
+    }
+
+    void rethrow()
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error) std::rethrow_exception(std::exchange(error, nullptr));
+    }
+
+    std::atomic<std::size_t> pending{0};
+    std::mutex wait_mutex;
+    std::condition_variable wait_cv;
+    bool released = false;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+class ForkJoinPool
+{
+public:
+    // on_start(index) runs first on each worker thread, e.g. to pin it to a set of CPUs
+    explicit ForkJoinPool(std::size_t numThreads = std::thread::hardware_concurrency(),
+                          std::function<void(std::size_t)> on_start_ = {})
+        : on_start(std::move(on_start_))
+    {
+        if (numThreads == 0) numThreads = 1;
+
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            workers.push_back(std::make_unique<Worker>());
+            workers.back()->index = i;
+        }
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            threads.emplace_back(&ForkJoinPool::workerThread, this, workers[i].get());
+        }
+    }
+
+    ~ForkJoinPool()
+    {
+        stop.store(true);
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            epoch.fetch_add(1);
+        }
+        sleep_cv.notify_all();
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+    std::size_t size() const { return workers.size(); }
+
+    // Index of the calling worker in this pool, or -1 for outside threads
+    int current_worker() const
+    {
+        return (current && current->pool == this) ? static_cast<int>(current->index) : -1;
+    }
+
+    template <typename F>
+    void spawn(TaskGroup& group, F&& f)
+    {
+        Task* task = new FunctionTask<std::decay_t<F>>(std::forward<F>(f));
+        task->group = &group;
+        group.add();
+        push(task);
+    }
+
+    // Detached task, not counted in any group: completion is signalled by the task
+    // itself (see continuation.hpp). An exception escaping it terminates the program.
+    template <typename F>
+    void spawn(F&& f)
+    {
+        push(new FunctionTask<std::decay_t<F>>(std::forward<F>(f)));
+    }
+
+    void sync(TaskGroup& group)
+    {
+        if (current && current->pool == this)
+        {
+            // Help: execute other tasks until the group has drained
+            while (!group.done())
+            {
+                if (Task* task = find_task(current))
+                {
+                    execute(task);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        else
+        {
+            group.wait();
+        }
+        group.rethrow();
+    }
+
+    // Run f on a worker and block the calling thread until it returns
+    template <typename F>
+    auto invoke(F&& f) -> std::invoke_result_t<F&>
+    {
+        using R = std::invoke_result_t<F&>;
+        TaskGroup group;
+
+        if constexpr (std::is_void_v<R>)
+        {
+            spawn(group, [&f] { f(); });
+            sync(group);
+        }
+        else
+        {
+            std::optional<R> result;
+            spawn(group, [&f, &result] { result.emplace(f()); });
+            sync(group);
+            return std::move(*result);
+        }
+    }
+
+private:
+    struct Worker
+    {
+        ForkJoinPool* pool = nullptr;
+        std::size_t index = 0;
+        ChaseLevDeque<Task*> deque;
+        std::minstd_rand rng;
+    };
+
+    static inline thread_local Worker* current = nullptr;
+
+    void workerThread(Worker* self)
+    {
+        self->pool = this;
+        self->rng.seed(static_cast<unsigned>(self->index) + 1);
+        current = self;
+        if (on_start) on_start(self->index);
+
+        while (!stop.load(std::memory_order_acquire))
+        {
+            if (Task* task = find_task(self))
+            {
+                execute(task);
+                continue;
+            }
+
+            // Spin a little before parking: new work usually shows up quickly
+            bool found = false;
+            for (int spin = 0; spin < 64 && !found; ++spin)
+            {
+                std::this_thread::yield();
+                if (Task* task = find_task(self))
+                {
+                    execute(task);
+                    found = true;
+                }
+            }
+            if (!found) park(self);
+        }
+
+        current = nullptr;
+    }
+
+    void push(Task* task)
+    {
+        if (current && current->pool == this)
+        {
+            current->deque.push(task);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(inject_mutex);
+            injected.push_back(task);
+            injected_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        notify_work();
+    }
+
+    void park(Worker* self)
+    {
+        std::uint64_t seen = epoch.load();
+        sleepers.fetch_add(1);
+
+        // Re-check after announcing ourselves, a spawner may have missed us
+        if (Task* task = find_task(self))
+        {
+            sleepers.fetch_sub(1);
+            execute(task);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [&] { return epoch.load() != seen || stop.load(); });
+        sleepers.fetch_sub(1);
+    }
+
+    void notify_work()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                epoch.fetch_add(1);
+            }
+            sleep_cv.notify_one();
+        }
+    }
+
+    Task* find_task(Worker* self)
+    {
+        if (Task* task = self->deque.pop()) return task;
+
+        if (injected_count.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(inject_mutex);
+            if (!injected.empty())
+            {
+                Task* task = injected.front();
+                injected.pop_front();
+                injected_count.fetch_sub(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+
+        // Steal from the top of a random victim's deque
+        std::size_t n = workers.size();
+        std::size_t start = self->rng() % n;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            Worker* victim = workers[(start + i) % n].get();
+            if (victim == self) continue;
+            if (Task* task = victim->deque.steal()) return task;
+        }
+        return nullptr;
+    }
+
+    static void execute(Task* task)
+    {
+        TaskGroup* group = task->group;
+        if (!group)
+        {
+            // Detached: nobody is there to receive the exception
+            try
+            {
+                task->run();
+            }
+            catch (...)
+            {
+                std::terminate();
+            }
+            delete task;
+            return;
+        }
+
+        try
+        {
+            task->run();
+        }
+        catch (...)
+        {
+            group->fail(std::current_exception());
+        }
+        delete task;
+        group->finish();
+    }
+
+    std::function<void(std::size_t)> on_start;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stop{false};
+
+    // Tasks submitted from threads that are not workers of this pool
+    std::mutex inject_mutex;
+    std::deque<Task*> injected;
+    std::atomic<std::size_t> injected_count{0};
+
+    // Parking of idle workers
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    std::atomic<std::uint64_t> epoch{0};
+    std::atomic<int> sleepers{0};
+};
@@ -0,0 +1,682 @@
+/*
+
+Composable futures
+
+std::future can only be consumed by a thread that blocks in get() or wait(), so
+combining N futures costs a waiting thread (or N waits in a fixed order), and a
+chain of dependent steps keeps a thread parked between the steps.
+
+Future<T> / Promise<T> share a state that, in addition to get() and wait(),
+accepts one continuation:
+
+on_ready(f)   : runs f once the value or the exception is set, on the thread that
+                sets it (or immediately if it is already set). The combinators in
+                when.hpp are built on it, without any waiting thread. There is
+                room for a single callback: a second on_ready on the same shared
+                state throws std::future_error (future_already_retrieved).
+then(f)       : consumes the future and returns a Future of f's result. f receives
+                the value (nothing for Future<void>), or the whole ready Future<T>
+                if it accepts one, to handle errors itself. An exception skips f
+                and reaches the returned future. If f returns a Future<U>, the
+                result is a Future<U> (not a future of a future). Throws
+                std::future_error (no_state) if the future is not valid().
+via(executor) : continuations attached after via() run on the executor instead of
+                the thread that completed the future; the futures returned by
+                then() keep that executor.
+
+The continuation is stored in the shared state in a small inline buffer
+(detail::Callback, callback.hpp). The job then() stores there holds f, the input
+state and the promise of the result, 40 bytes plus f, so a continuation whose
+captures fit in 24 bytes is not allocated: then() costs the shared state of its
+result and nothing else. After via(), the job is handed to the executor as is
+when the executor accepts move-only tasks (move_only_tasks, as BoundedExecutor
+does), and through a shared_ptr wrapper otherwise. A future made ready without a
+promise (make_ready_future, or then() on a ready future without an executor)
+holds its value itself and has no shared state at all.
+
+async_on(executor, f, args...)        : runs f on an executor (anything with a
+                                        submit(callable) member) and returns a
+                                        Future of its result. A move_only_tasks
+                                        executor gets the promise by move,
+                                        without a heap allocation.
+async_on(executor, token, f, args...) : same, but f is not started once stop has
+                                        been requested on the std::stop_token,
+                                        and receives the token as first argument
+                                        if it accepts it.
+
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include "callback.hpp"
+
+// The executor refused the task (e.g. BoundedExecutor with Overflow::Reject)
+class TaskRejected : public std::runtime_error
+{
+public:
+    TaskRejected() : std::runtime_error("task rejected by the executor") {}
+};
+
+// Stop was requested before the task started
+class OperationCancelled : public std::runtime_error
+{
+public:
+    OperationCancelled() : std::runtime_error("operation cancelled") {}
+};
+
+template <typename T>
+class Future;
+
+template <typename T>
+class Promise;
+
+namespace detail
+{
+
+// Future<void> stores an empty value, so the state and the combinators need no special case
+template <typename T>
+using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template <typename T>
+struct is_future : std::false_type {};
+
+template <typename T>
+struct is_future<Future<T>> : std::true_type {};
+
+// submit() may return bool (false: rejected) or nothing
+template <typename Executor, typename Task>
+bool submit_to(Executor& executor, Task&& task)
+{
+    if constexpr (std::is_same_v<decltype(executor.submit(std::forward<Task>(task))), bool>)
+    {
+        return executor.submit(std::forward<Task>(task));
+    }
+    else
+    {
+        executor.submit(std::forward<Task>(task));
+        return true;
+    }
+}
+
+// An executor that sets move_only_tasks takes a move-only task by forwarding reference and
+// leaves it untouched when it rejects it
+template <typename Executor>
+concept MoveOnlyTasks = requires { requires Executor::move_only_tasks; };
+
+// Type-erased reference to the executor chosen with via()
+struct Scheduler
+{
+    void* executor = nullptr;
+    void (*schedule)(void* executor, Callback&& job) = nullptr;
+
+    explicit operator bool() const { return schedule != nullptr; }
+
+    template <typename Executor>
+    static Scheduler of(Executor& executor)
+    {
+        return {&executor, [](void* e, Callback&& job)
+        {
+            Executor& target = *static_cast<Executor*>(e);
+            if constexpr (MoveOnlyTasks<Executor>)
+            {
+                if (!submit_to(target, std::move(job))) job(); // Rejected: run here rather than lose the continuation
+            }
+            else
+            {
+                // std::function needs a copyable callable
+                auto shared = std::make_shared<Callback>(std::move(job));
+                if (!submit_to(target, [shared] { (*shared)(); })) (*shared)();
+            }
+        }};
+    }
+
+    // Runs job here, or hands it to the executor if there is one
+    void run(Callback&& job) const
+    {
+        if (schedule) schedule(executor, std::move(job));
+        else job();
+    }
+};
+
+template <typename T>
+class SharedState
+{
+public:
+    template <typename... Args>
+    void set_value(Args&&... args)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (ready) throw std::future_error(std::future_errc::promise_already_satisfied);
+        value.emplace(std::forward<Args>(args)...);
+        complete(lock);
+    }
+
+    void set_exception(std::exception_ptr e)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (ready) throw std::future_error(std::future_errc::promise_already_satisfied);
+        error = std::move(e);
+        complete(lock);
+    }
+
+    bool is_ready() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return ready;
+    }
+
+    void wait() const
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!ready)
+        {
+            waiting = true;
+            cv.wait(lock, [this] { return ready; });
+        }
+    }
+
+    // Moves the value out, or rethrows the exception. Only after wait().
+    Stored<T> take()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+
+    // At most one callback per state, run on `on` if given
+    void on_ready(Callback callback, Scheduler on = {})
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (registered) throw std::future_error(std::future_errc::future_already_retrieved);
+        registered = true;
+        if (!ready)
+        {
+            continuation = std::move(callback);
+            continuation_on = on;
+            return;
+        }
+        lock.unlock();
+        on.run(std::move(callback));
+    }
+
+private:
+    // Publishes the result, then runs the continuation outside the lock
+    void complete(std::unique_lock<std::mutex>& lock)
+    {
+        ready = true;
+        Callback pending = std::move(continuation);
+        Scheduler on = continuation_on;
+        bool notify = waiting;
+        lock.unlock();
+
+        if (notify) cv.notify_all(); // No blocked get(): no syscall
+        if (pending) on.run(std::move(pending));
+    }
+
+    mutable std::mutex mtx;
+    mutable std::condition_variable cv;
+    mutable bool waiting = false;
+    bool ready = false;
+    bool registered = false;
+    std::optional<Stored<T>> value;
+    std::exception_ptr error;
+    Callback continuation;
+    Scheduler continuation_on;
+};
+
+} // namespace detail
+
+template <typename T>
+class Future
+{
+public:
+    using value_type = T;
+
+    Future() = default;
+    Future(Future&&) noexcept = default;
+    Future& operator=(Future&&) noexcept = default;
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    bool valid() const { return state != nullptr || value.has_value() || error != nullptr; }
+    bool is_ready() const { return state ? state->is_ready() : valid(); }
+
+    void wait() const
+    {
+        if (state) state->wait();
+    }
+
+    // Blocks until the result is set, then returns it or rethrows the task's exception.
+    // Throws std::future_error (no_state) if the future is not valid().
+    T get()
+    {
+        detail::Stored<T> result = take();
+        if constexpr (!std::is_void_v<T>)
+        {
+            return result;
+        }
+    }
+
+    // Runs callback once the result is set, on the thread that sets it. One callback per future:
+    // a second one throws std::future_error.
+    void on_ready(detail::Callback callback) const
+    {
+        if (state)
+        {
+            state->on_ready(std::move(callback));
+        }
+        else
+        {
+            callback();
+        }
+    }
+
+    // Continuations attached to the returned future run on `executor`
+    template <typename Executor>
+    Future via(Executor& executor) &&
+    {
+        Future result = std::move(*this);
+        result.scheduler = detail::Scheduler::of(executor);
+        return result;
+    }
+
+    // Returns a Future of f's result, without waiting for this one.
+    // Throws std::future_error (no_state) if the future is not valid().
+    template <typename F>
+    auto then(F f) &&;
+
+    // Completes `promise` with this future's result, once it is set. An invalid
+    // future fails it with std::future_error (no_state).
+    void forward_to(Promise<T> promise) &&
+    {
+        if (!state)
+        {
+            if (error) promise.set_exception(std::move(error));
+            else if (value) promise.set_value(std::move(*value));
+            else promise.set_exception(std::make_exception_ptr(std::future_error(std::future_errc::no_state)));
+            return;
+        }
+
+        std::shared_ptr<detail::SharedState<T>> s = std::move(state);
+        detail::SharedState<T>& ref = *s;
+        ref.on_ready([s = std::move(s), promise = std::move(promise)]() mutable
+        {
+            try
+            {
+                promise.set_value(s->take());
+            }
+            catch (...)
+            {
+                promise.set_exception(std::current_exception());
+            }
+        });
+    }
+
+private:
+    template <typename U>
+    friend class Future;
+
+    template <typename U>
+    friend class Promise;
+
+    template <typename U>
+    friend Future<std::decay_t<U>> make_ready_future(U&& value);
+
+    friend Future<void> make_ready_future();
+
+    template <typename U>
+    friend Future<U> make_exceptional_future(std::exception_ptr error);
+
+    explicit Future(std::shared_ptr<detail::SharedState<T>> state_) : state(std::move(state_)) {}
+
+    detail::Stored<T> take()
+    {
+        if (std::shared_ptr<detail::SharedState<T>> s = std::move(state))
+        {
+            s->wait();
+            return s->take();
+        }
+        if (error) std::rethrow_exception(std::exchange(error, nullptr));
+        if (!value) throw std::future_error(std::future_errc::no_state); // Default-constructed, moved from or consumed
+        detail::Stored<T> result = std::move(*value);
+        value.reset();
+        return result;
+    }
+
+    std::shared_ptr<detail::SharedState<T>> state;
+    std::optional<detail::Stored<T>> value; // ready without shared state
+    std::exception_ptr error;               // failed without shared state
+    detail::Scheduler scheduler;
+};
+
+template <typename T>
+class Promise
+{
+public:
+    Promise() : state(std::make_shared<detail::SharedState<T>>()) {}
+
+    Promise(Promise&& other) noexcept
+        : state(std::move(other.state)), satisfied(std::exchange(other.satisfied, true))
+    {
+    }
+
+    Promise& operator=(Promise&& other) noexcept
+    {
+        if (this != &other)
+        {
+            abandon();
+            state = std::move(other.state);
+            satisfied = std::exchange(other.satisfied, true);
+        }
+        return *this;
+    }
+
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+
+    // Like std::promise, a promise destroyed without a result breaks its future
+    ~Promise() { abandon(); }
+
+    Future<T> get_future() { return Future<T>(state); }
+
+    template <typename... Args>
+    void set_value(Args&&... args)
+    {
+        satisfied = true;
+        state->set_value(std::forward<Args>(args)...);
+    }
+
+    void set_exception(std::exception_ptr e)
+    {
+        satisfied = true;
+        state->set_exception(std::move(e));
+    }
+
+private:
+    template <typename U>
+    friend class Future;
+
+    void abandon()
+    {
+        if (state && !satisfied)
+        {
+            state->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+    std::shared_ptr<detail::SharedState<T>> state;
+    bool satisfied = false;
+};
+
+template <typename U>
+Future<std::decay_t<U>> make_ready_future(U&& value)
+{
+    Future<std::decay_t<U>> future;
+    future.value.emplace(std::forward<U>(value));
+    return future;
+}
+
+inline Future<void> make_ready_future()
+{
+    Future<void> future;
+    future.value.emplace();
+    return future;
+}
+
+template <typename T>
+Future<T> make_exceptional_future(std::exception_ptr error)
+{
+    Future<T> future;
+    future.error = std::move(error);
+    return future;
+}
+
+namespace detail
+{
+
+// What then(f) passes to f: the whole future if f takes one, otherwise the value
+template <typename F, typename T>
+auto call_continuation(F& f, Future<T>& input)
+{
+    if constexpr (std::is_invocable_v<F&, Future<T>>)
+    {
+        return std::invoke(f, std::move(input));
+    }
+    else if constexpr (std::is_void_v<T>)
+    {
+        input.get();
+        return std::invoke(f);
+    }
+    else
+    {
+        return std::invoke(f, input.get());
+    }
+}
+
+template <typename F, typename T>
+using continuation_result_t = decltype(call_continuation(std::declval<F&>(), std::declval<Future<T>&>()));
+
+// Future<U> for a continuation returning U or Future<U>
+template <typename R>
+struct unwrap_future
+{
+    using type = R;
+};
+
+template <typename U>
+struct unwrap_future<Future<U>>
+{
+    using type = U;
+};
+
+// Runs f on the ready input and completes promise with its result
+template <typename F, typename T, typename U>
+void run_continuation(F& f, Future<T>& input, Promise<U>& promise)
+{
+    using R = continuation_result_t<F, T>;
+    if constexpr (is_future<R>::value)
+    {
+        R next;
+        try
+        {
+            next = call_continuation(f, input);
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+            return;
+        }
+        std::move(next).forward_to(std::move(promise)); // Last step: nothing may use `promise` after the move
+    }
+    else
+    {
+        try
+        {
+            if constexpr (std::is_void_v<R>)
+            {
+                call_continuation(f, input);
+                promise.set_value();
+            }
+            else
+            {
+                promise.set_value(call_continuation(f, input));
+            }
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+    }
+}
+
+// then() on a ready future without executor: no shared state for the result
+template <typename F, typename T>
+auto run_ready_continuation(F& f, Future<T>& input)
+{
+    using R = continuation_result_t<F, T>;
+    using U = typename unwrap_future<R>::type;
+    try
+    {
+        if constexpr (is_future<R>::value)
+        {
+            return call_continuation(f, input);
+        }
+        else if constexpr (std::is_void_v<R>)
+        {
+            call_continuation(f, input);
+            return make_ready_future();
+        }
+        else
+        {
+            return make_ready_future(call_continuation(f, input));
+        }
+    }
+    catch (...)
+    {
+        return make_exceptional_future<U>(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+template <typename T>
+template <typename F>
+auto Future<T>::then(F f) &&
+{
+    using U = typename detail::unwrap_future<detail::continuation_result_t<F, T>>::type;
+
+    if (!state && !error && !value) throw std::future_error(std::future_errc::no_state); // Default-constructed, moved from or consumed
+    if (!state && !scheduler)
+    {
+        return detail::run_ready_continuation(f, *this);
+    }
+    if (!state)
+    {
+        // Ready without shared state, but f must still run on the executor
+        state = std::make_shared<detail::SharedState<T>>();
+        if (error) state->set_exception(std::exchange(error, nullptr));
+        else state->set_value(std::move(*value));
+        value.reset();
+    }
+
+    Promise<U> promise;
+    Future<U> result = promise.get_future();
+    result.scheduler = scheduler; // Later then() calls keep the executor
+
+    // The job owns the input state until it has run. Kept to f plus two shared_ptr and a flag,
+    // so that it fits in the inline buffer of the callback
+    std::shared_ptr<detail::SharedState<T>> input = std::move(state);
+    detail::SharedState<T>& ref = *input;
+    ref.on_ready([f = std::move(f), input = std::move(input), promise = std::move(promise)]() mutable
+    {
+        Future<T> ready(std::move(input));
+        detail::run_continuation(f, ready, promise);
+    }, scheduler);
+    return result;
+}
+
+namespace detail
+{
+
+// Calls f(args...) and stores its result or its exception in the promise
+template <typename R, typename F, typename... Args>
+void fulfil(Promise<R>& promise, F& f, Args&... args)
+{
+    try
+    {
+        if constexpr (std::is_void_v<R>)
+        {
+            std::invoke(f, args...);
+            promise.set_value();
+        }
+        else
+        {
+            promise.set_value(std::invoke(f, args...));
+        }
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+// The task async_on() hands to a move-only executor; still holds the promise if it is rejected
+template <typename R, typename F, typename... Args>
+struct AsyncTask
+{
+    Promise<R> promise;
+    F f;
+    std::tuple<Args...> args;
+
+    void operator()()
+    {
+        std::apply([this](Args&... a) { fulfil(promise, f, a...); }, args);
+    }
+};
+
+} // namespace detail
+
+template <typename Executor, typename F, typename... Args>
+auto async_on(Executor& executor, F f, Args... args) -> Future<std::invoke_result_t<F&, Args&...>>
+{
+    using R = std::invoke_result_t<F&, Args&...>;
+
+    if constexpr (detail::MoveOnlyTasks<Executor>)
+    {
+        detail::AsyncTask<R, F, Args...> task{Promise<R>(), std::move(f), {std::move(args)...}};
+        Future<R> future = task.promise.get_future();
+        if (!detail::submit_to(executor, std::move(task)))
+        {
+            task.promise.set_exception(std::make_exception_ptr(TaskRejected()));
+        }
+        return future;
+    }
+    else
+    {
+        // std::function needs a copyable callable: the promise lives in a shared_ptr
+        auto promise = std::make_shared<Promise<R>>();
+        Future<R> future = promise->get_future();
+
+        bool accepted = detail::submit_to(executor, [promise, f = std::move(f), ... args = std::move(args)]() mutable
+        {
+            detail::fulfil(*promise, f, args...);
+        });
+        if (!accepted)
+        {
+            promise->set_exception(std::make_exception_ptr(TaskRejected()));
+        }
+        return future;
+    }
+}
+
+template <typename Executor, typename F, typename... Args>
+auto async_on(Executor& executor, std::stop_token token, F f, Args... args)
+{
+    return async_on(executor, [token, f = std::move(f), ... args = std::move(args)]() mutable
+    {
+        if (token.stop_requested()) throw OperationCancelled();
+
+        if constexpr (std::is_invocable_v<F&, std::stop_token, Args&...>)
+        {
+            return std::invoke(f, token, args...);
+        }
+        else
+        {
+            return std::invoke(f, args...);
+        }
+    });
+}
@@ -0,0 +1,324 @@
+/*
+
+NUMA-aware fork-join reductions
+
+A std::vector filled by main() has all its pages on main's NUMA node, so on a
+multi-socket machine every other socket reads it over the interconnect.
+
+NumaTopology : NUMA nodes and their CPUs, read from /sys/devices/system/node.
+               A host without that information is treated as a single node.
+NumaPool     : one ForkJoinPool per node, its workers pinned to that node's CPUs,
+               so work stealing never moves a task to another node.
+NumaArray<T> : array split into one page-aligned block per node. Each block is
+               bound to its node with mbind(MPOL_PREFERRED) and first touched
+               (initialized) by the workers of that node.
+numa_reduce  : reduces each node's block on the node's own pool with
+               parallel_reduce and combines the per-node results.
+
+On a single-node host nothing is bound or pinned and numa_reduce is a plain
+parallel_reduce on one pool. No libnuma is needed: mbind and the affinity calls
+are made directly and their failure only costs locality, never correctness.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "partitioner.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class NumaTopology
+{
+public:
+    NumaTopology()
+    {
+#ifdef __linux__
+        for (int node : parse_list(read_file("/sys/devices/system/node/online")))
+        {
+            std::vector<int> cpus = parse_list(read_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+            if (!cpus.empty())
+            {
+                nodes.push_back({node, std::move(cpus)});
+            }
+        }
+#endif
+        if (nodes.empty())
+        {
+            // No NUMA information: one node owning every CPU
+            std::vector<int> cpus;
+            for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency()); ++i)
+            {
+                cpus.push_back(static_cast<int>(i));
+            }
+            nodes.push_back({0, std::move(cpus)});
+        }
+    }
+
+    struct Node
+    {
+        int id;
+        std::vector<int> cpus;
+    };
+
+    std::size_t size() const { return nodes.size(); }
+    const Node& node(std::size_t i) const { return nodes[i]; }
+
+private:
+    static std::string read_file(const std::string& path)
+    {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    // "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}
+    static std::vector<int> parse_list(const std::string& text)
+    {
+        std::vector<int> values;
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            if (item.empty()) continue;
+            std::size_t dash = item.find('-');
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            for (int v = first; v <= last; ++v) values.push_back(v);
+        }
+        return values;
+    }
+
+    std::vector<Node> nodes;
+};
+
+class NumaPool
+{
+public:
+    // threads_per_node == 0: one worker per CPU of the node
+    explicit NumaPool(std::size_t threads_per_node = 0)
+    {
+        bool pin = topology.size() > 1;
+        for (std::size_t i = 0; i < topology.size(); ++i)
+        {
+            const std::vector<int>& cpus = topology.node(i).cpus;
+            std::size_t threads = threads_per_node ? threads_per_node : cpus.size();
+
+            std::function<void(std::size_t)> on_start;
+            if (pin)
+            {
+                on_start = [cpus](std::size_t) { pin_to(cpus); };
+            }
+            pools.push_back(std::make_unique<ForkJoinPool>(threads, on_start));
+        }
+    }
+
+    std::size_t nodes() const { return pools.size(); }
+    int node_id(std::size_t i) const { return topology.node(i).id; }
+    ForkJoinPool& pool(std::size_t i) { return *pools[i]; }
+
+    // Runs f(i) on the pool of every node i in parallel and waits for all of them
+    template <typename F>
+    void on_each_node(F f)
+    {
+        std::vector<std::unique_ptr<TaskGroup>> groups;
+        for (std::size_t i = 0; i < pools.size(); ++i)
+        {
+            groups.push_back(std::make_unique<TaskGroup>());
+            pools[i]->spawn(*groups.back(), [&f, i] { f(i); });
+        }
+
+        // Wait for every node before rethrowing, the tasks reference f
+        std::exception_ptr error;
+        for (std::size_t i = 0; i < pools.size(); ++i)
+        {
+            try
+            {
+                pools[i]->sync(*groups[i]);
+            }
+            catch (...)
+            {
+                if (!error) error = std::current_exception();
+            }
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    static void pin_to(const std::vector<int>& cpus)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set); // Best effort, e.g. restricted by a cpuset
+#else
+        (void)cpus;
+#endif
+    }
+
+    NumaTopology topology;
+    std::vector<std::unique_ptr<ForkJoinPool>> pools;
+};
+
+// Fixed-size array whose pages are spread over the nodes of a NumaPool, one block per node
+template <typename T>
+class NumaArray
+{
+    static_assert(std::is_trivially_destructible_v<T>, "NumaArray holds plain values");
+
+public:
+    NumaArray(NumaPool& pool, std::size_t n_, const T& value = T()) : n(n_)
+    {
+        std::size_t page = page_size();
+        std::size_t per_page = std::max<std::size_t>(1, page / sizeof(T));
+
+        // Blocks of whole pages, so that no page is shared by two nodes
+        std::size_t pages = (n * sizeof(T) + page - 1) / page;
+        std::size_t pages_per_node = (pages + pool.nodes() - 1) / pool.nodes();
+        for (std::size_t i = 0; i < pool.nodes(); ++i)
+        {
+            std::size_t begin = std::min(n, i * pages_per_node * per_page);
+            std::size_t end = std::min(n, (i + 1) * pages_per_node * per_page);
+            blocks.push_back({begin, end});
+        }
+
+        bytes = std::max<std::size_t>(pages, 1) * page;
+        allocate();
+
+        if (pool.nodes() > 1)
+        {
+            for (std::size_t i = 0; i < pool.nodes(); ++i)
+            {
+                bind(blocks[i].first, blocks[i].second, pool.node_id(i));
+            }
+        }
+
+        // First touch: each node's workers write their own block
+        pool.on_each_node([&](std::size_t i)
+        {
+            auto [begin, end] = blocks[i];
+            parallel_reduce(pool.pool(i), begin, end, 0,
+                [this, &value](std::size_t first, std::size_t last)
+                {
+                    std::uninitialized_fill(data + first, data + last, value);
+                    return 0;
+                },
+                [](int, int) { return 0; },
+                SimplePartitioner(per_page * 16));
+        });
+    }
+
+    ~NumaArray()
+    {
+#ifdef __linux__
+        munmap(data, bytes);
+#else
+        ::operator delete(data, std::align_val_t(page_size()));
+#endif
+    }
+
+    NumaArray(const NumaArray&) = delete;
+    NumaArray& operator=(const NumaArray&) = delete;
+
+    std::size_t size() const { return n; }
+    T* begin() { return data; }
+    T* end() { return data + n; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + n; }
+    T& operator[](std::size_t i) { return data[i]; }
+    const T& operator[](std::size_t i) const { return data[i]; }
+
+    // Element range [first, second) placed on node i of the pool
+    std::pair<std::size_t, std::size_t> block(std::size_t i) const { return blocks[i]; }
+
+private:
+    static std::size_t page_size()
+    {
+#ifdef __linux__
+        return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 4096;
+#endif
+    }
+
+    void allocate()
+    {
+#ifdef __linux__
+        // mmap does not touch the pages, so they are placed on first write
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        data = static_cast<T*>(p);
+#else
+        data = static_cast<T*>(::operator new(bytes, std::align_val_t(page_size())));
+#endif
+    }
+
+    void bind(std::size_t first, std::size_t last, int node)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        if (first >= last) return;
+
+        constexpr int mpol_preferred = 1; // MPOL_PREFERRED from <numaif.h>
+        constexpr std::size_t mask_bits = 1024;
+        unsigned long mask[mask_bits / (8 * sizeof(unsigned long))] = {};
+        if (node < 0 || static_cast<std::size_t>(node) >= mask_bits) return;
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+
+        // Best effort: without mbind, first touch by the node's workers still places the pages
+        syscall(SYS_mbind, data + first, (last - first) * sizeof(T), mpol_preferred, mask, mask_bits + 1, 0);
+#else
+        (void)first;
+        (void)last;
+        (void)node;
+#endif
+    }
+
+    std::size_t n;
+    std::size_t bytes = 0;
+    T* data = nullptr;
+    std::vector<std::pair<std::size_t, std::size_t>> blocks;
+};
+
+// Reduces each node's block of the array on that node's pool and combines the results
+template <typename Partitioner = AutoPartitioner, typename T, typename U, typename Leaf, typename Combine>
+T numa_reduce(NumaPool& pool, const NumaArray<U>& array, T identity, Leaf leaf, Combine combine)
+{
+    std::vector<T> partial(pool.nodes(), identity);
+    pool.on_each_node([&](std::size_t i)
+    {
+        auto [begin, end] = array.block(i);
+        Partitioner partitioner;
+        partial[i] = parallel_reduce(pool.pool(i), begin, end, identity, leaf, combine, partitioner);
+    });
+
+    T result = identity;
+    for (const T& value : partial)
+    {
+        result = combine(result, value);
+    }
+    return result;
+}
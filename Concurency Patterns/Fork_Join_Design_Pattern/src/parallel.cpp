@@ -1,37 +1,53 @@
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <vector>
-#include <future>
+#include "fork_join_pool.hpp"
+#include "partitioner.hpp"
+#include "simd_reduce.hpp"
 
-// Function to compute the sum of elements in a range
-int parallel_sum(const std::vector<int>& arr, int start, int end)
+// Function to compute the sum of elements in a range, split as decided by the partitioner
+std::int64_t parallel_sum(ForkJoinPool& pool, const std::vector<int>& arr, std::size_t start, std::size_t end,
+                          AutoPartitioner& partitioner, AutoPartitioner::State state)
 {
-    // Base case: if the range is small, compute directly
-    if (end - start < 1000)
+    // Base case: the partitioner says the range is not worth splitting, compute directly
+    // with the vectorized kernel (64-bit accumulators); run_leaf times it to tune later splits
+    std::size_t n = end - start;
+    if (!partitioner.divisible(state, n))
     {
-        int sum = 0;
-        for (int i = start; i < end; ++i)
-        {
-            sum += arr[i];
-        }
-        return sum;
+        return partitioner.run_leaf([&arr](std::size_t first, std::size_t last) { return simd::sum(arr.data() + first, last - first); },
+                                    start, end);
     }
 
-    // Recursive case: split the range and compute in parallel
-    int mid = start + (end - start) / 2;
-    auto left_future = std::async(std::launch::async, parallel_sum, std::ref(arr), start, mid);
-    auto right_future = std::async(std::launch::async, parallel_sum, std::ref(arr), mid, end);
+    // Recursive case: split the range, the left part becomes a task that idle workers can steal
+    Split<AutoPartitioner::State> split = partitioner.split(state, n);
+    std::size_t mid = start + split.left_size;
+    std::int64_t left_sum = 0;
+    TaskGroup group;
+    int spawner = pool.current_worker();
+    pool.spawn(group, [&, spawner, left_state = split.left]() mutable
+    {
+        if (pool.current_worker() != spawner) partitioner.stolen(left_state); // A thief gets a bigger split budget
+        left_sum = parallel_sum(pool, arr, start, mid, partitioner, left_state);
+    });
+    std::int64_t right_sum = parallel_sum(pool, arr, mid, end, partitioner, split.right);
 
-    // Join: wait for both halves to complete and combine results
-    return left_future.get() + right_future.get();
+    // Join: run other tasks until the left part is done and combine results
+    pool.sync(group);
+    return left_sum + right_sum;
 }
 
 int main()
 {
+    // Fixed number of worker threads, no thread is created per split
+    ForkJoinPool pool;
+
     // Create a large array of integers
     std::vector<int> arr(10000, 1); // Array of 10000 elements, all initialized to 1
 
     // Compute the sum using parallel computation
-    int total_sum = parallel_sum(arr, 0, arr.size());
+    AutoPartitioner partitioner;
+    std::int64_t total_sum = pool.invoke([&] { return parallel_sum(pool, arr, 0, arr.size(), partitioner, partitioner.root(pool, arr.size())); });
 
     std::cout << "Total sum: " << total_sum << std::endl;
 
@@ -1,33 +1,70 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <vector>
-#include <future>
+#include "continuation.hpp"
+#include "fork_join_pool.hpp"
+#include "partitioner.hpp"
+#include "simd_reduce.hpp"
 
 int main()
 {
+    // Fixed number of worker threads, whatever the depth of the recursion
+    ForkJoinPool pool;
+
     // Create a large array of integers
     std::vector<int> arr(10000, 1); // Array of 10000 elements, all initialized to 1
 
-    // Lambda function to compute the sum of elements in a range
-    auto parallel_sum = &arr -> int
+    // Receives the sum of a range: the caller passes it down instead of waiting for a return value
+    using Continuation = std::function<void(std::int64_t)>;
+
+    // Decides where to split and when to stop, from the pool size, steals and measured leaf time
+    AutoPartitioner partitioner;
+
+    // Lambda function to compute the sum of elements in a range.
+    // A lambda cannot name itself, so it receives itself as the first argument.
+    auto parallel_sum = [&arr, &pool, &partitioner](auto& self, std::size_t start, std::size_t end,
+                                                    AutoPartitioner::State state, Continuation k) -> void
     {
-        if (end - start < 1000) {
-            int sum = 0;
-            for (int i = start; i < end; ++i)
-             {
-                sum += arr[i];
-            }
-            return sum;
+        // Base case: the partitioner says the range is not worth splitting; run_leaf times it to tune later splits
+        std::size_t n = end - start;
+        if (!partitioner.divisible(state, n))
+        {
+            k(partitioner.run_leaf([&arr](std::size_t first, std::size_t last) { return simd::sum(arr.data() + first, last - first); },
+                                   start, end));
+            return;
         }
 
-        int mid = start + (end - start) / 2;
-        auto left_future = std::async(std::launch::async, parallel_sum, start, mid);
-        auto right_future = std::async(std::launch::async, parallel_sum, mid, end);
+        // Join point: the last half to finish adds both results and passes the total up
+        auto* join = make_join<std::int64_t, 2>([k](const std::array<std::int64_t, 2>& sums)
+        {
+            k(sums[0] + sums[1]);
+        });
 
-        return left_future.get() + right_future.get();
+        // Fork: the left part may be stolen by an idle worker, the right part runs here.
+        // Neither call waits for the other, so no thread is parked at this level.
+        Split<AutoPartitioner::State> split = partitioner.split(state, n);
+        std::size_t mid = start + split.left_size;
+        int spawner = pool.current_worker();
+        pool.spawn([&self, &pool, &partitioner, spawner, start, mid, left_state = split.left, join]() mutable
+        {
+            if (pool.current_worker() != spawner) partitioner.stolen(left_state); // A thief gets a bigger split budget
+            self(self, start, mid, left_state, [join](std::int64_t sum) { join->arrive(0, sum); });
+        });
+        self(self, mid, end, split.right, [join](std::int64_t sum) { join->arrive(1, sum); });
     };
 
-    // Compute the sum using parallel computation
-    int total_sum = parallel_sum(0, arr.size());
+    // Compute the sum using parallel computation; only main waits, for the final result
+    std::promise<std::int64_t> total;
+    pool.spawn([&]
+    {
+        parallel_sum(parallel_sum, 0, arr.size(), partitioner.root(pool, arr.size()),
+                     [&total](std::int64_t sum) { total.set_value(sum); });
+    });
+    std::int64_t total_sum = total.get_future().get();
 
     std::cout << "Total sum: " << total_sum << std::endl;
 
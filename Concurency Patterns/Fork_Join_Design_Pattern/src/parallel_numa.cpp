@@ -0,0 +1,31 @@
+#include <cstdint>
+#include <iostream>
+#include "numa.hpp"
+#include "simd_reduce.hpp"
+
+int main()
+{
+    // One pool per NUMA node, workers pinned to the CPUs of their node
+    NumaPool pool;
+
+    // Create a large array of integers, each node's block first touched by that node's workers
+    NumaArray<int> arr(pool, 10000000, 1); // Array of 10M elements, all initialized to 1
+
+    // Compute the sum: every node reduces the block in its own memory
+    std::int64_t total_sum = numa_reduce(pool, arr, std::int64_t(0),
+        [&arr](std::size_t first, std::size_t last)
+        {
+            return simd::sum(arr.begin() + first, last - first);
+        },
+        [](std::int64_t left, std::int64_t right) { return left + right; });
+
+    for (std::size_t i = 0; i < pool.nodes(); ++i)
+    {
+        auto [first, last] = arr.block(i);
+        std::cout << "Node " << pool.node_id(i) << ": " << pool.pool(i).size() << " workers, elements ["
+                  << first << ", " << last << ")" << std::endl;
+    }
+    std::cout << "Total sum: " << total_sum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,242 @@
+/*
+
+Partitioners for parallel_reduce
+
+A partitioner decides how deep the recursive split of [begin, end) goes.
+
+SimplePartitioner(grain) : split until a range is not larger than grain.
+                           Predictable, but the right grain depends on the kernel.
+StaticPartitioner        : split once into one chunk per worker, proportionally,
+                           and never split again. Lowest overhead, no load balancing.
+AutoPartitioner          : split into about 4 chunks per worker, then let runtime
+                           feedback decide the rest:
+                           - a range that was stolen gets a bigger split budget,
+                             since a steal means some worker ran out of work;
+                           - measured leaf time gives an estimate of the cost per
+                             element, and ranges are not split below the size that
+                             runs for target_leaf_ns, so task overhead stays small.
+
+Every partitioner provides a per-range State and:
+
+    State root(ForkJoinPool& pool, std::size_t n)
+    bool divisible(const State& state, std::size_t n)
+    Split<State> split(const State& state, std::size_t n)
+    void stolen(State& state)
+    T run_leaf(const Leaf& leaf, std::size_t begin, std::size_t end)
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <type_traits>
+#include "fork_join_pool.hpp"
+
+template <typename State>
+struct Split
+{
+    std::size_t left_size;
+    State left;
+    State right;
+};
+
+class SimplePartitioner
+{
+public:
+    struct State {};
+
+    explicit SimplePartitioner(std::size_t grain_ = 1) : grain(grain_ == 0 ? 1 : grain_) {}
+
+    State root(ForkJoinPool&, std::size_t) { return {}; }
+    bool divisible(const State&, std::size_t n) const { return n > grain; }
+    Split<State> split(const State&, std::size_t n) const { return {n / 2, {}, {}}; }
+    void stolen(State&) {}
+
+    template <typename Leaf>
+    auto run_leaf(const Leaf& leaf, std::size_t begin, std::size_t end) const { return leaf(begin, end); }
+
+private:
+    std::size_t grain;
+};
+
+class StaticPartitioner
+{
+public:
+    // Number of chunks still to be carved out of the range
+    struct State
+    {
+        std::size_t chunks;
+    };
+
+    State root(ForkJoinPool& pool, std::size_t) { return {pool.size()}; }
+    bool divisible(const State& state, std::size_t n) const { return state.chunks > 1 && n > 1; }
+
+    Split<State> split(const State& state, std::size_t n) const
+    {
+        std::size_t left_chunks = state.chunks / 2;
+        std::size_t right_chunks = state.chunks - left_chunks;
+        return {n * left_chunks / state.chunks, {left_chunks}, {right_chunks}};
+    }
+
+    void stolen(State&) {}
+
+    template <typename Leaf>
+    auto run_leaf(const Leaf& leaf, std::size_t begin, std::size_t end) const { return leaf(begin, end); }
+};
+
+class AutoPartitioner
+{
+public:
+    // Remaining number of splits allowed on this range
+    struct State
+    {
+        int depth;
+    };
+
+    struct Stats
+    {
+        std::size_t leaves;
+        std::size_t steals;
+        double ns_per_element;
+        std::size_t grain;
+    };
+
+    // target_leaf_ns: how long one leaf should run so that the spawn/steal cost is negligible
+    explicit AutoPartitioner(double target_leaf_ns_ = 20000.0) : target_leaf_ns(target_leaf_ns_) {}
+
+    // The partitioner keeps its cost estimate, so it can be reused across calls on similar kernels
+    AutoPartitioner(const AutoPartitioner&) = delete;
+    AutoPartitioner& operator=(const AutoPartitioner&) = delete;
+
+    State root(ForkJoinPool& pool, std::size_t)
+    {
+        // About 4 chunks per worker gives enough slack to absorb small imbalances
+        int depth = 2;
+        for (std::size_t p = 1; p < pool.size(); p <<= 1) ++depth;
+        return {depth};
+    }
+
+    bool divisible(const State& state, std::size_t n) const
+    {
+        return state.depth > 0 && n > 1 && n / 2 >= grain();
+    }
+
+    Split<State> split(const State& state, std::size_t n) const
+    {
+        return {n / 2, {state.depth - 1}, {state.depth - 1}};
+    }
+
+    void stolen(State& state)
+    {
+        // A thief was idle: give this range room to be split further
+        steals.fetch_add(1, std::memory_order_relaxed);
+        state.depth = std::max(state.depth, 0) + steal_depth_bonus;
+    }
+
+    template <typename Leaf>
+    auto run_leaf(const Leaf& leaf, std::size_t begin, std::size_t end)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto result = leaf(begin, end);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        record(ns / static_cast<double>(end - begin));
+        return result;
+    }
+
+    // Smallest range worth splitting, derived from the measured cost per element
+    std::size_t grain() const
+    {
+        double cost = ns_per_element.load(std::memory_order_relaxed);
+        if (cost <= 0.0) return 1; // Nothing measured yet: only the depth budget applies
+        return std::max<std::size_t>(1, static_cast<std::size_t>(target_leaf_ns / cost));
+    }
+
+    Stats stats() const
+    {
+        return {leaves.load(std::memory_order_relaxed), steals.load(std::memory_order_relaxed),
+                ns_per_element.load(std::memory_order_relaxed), grain()};
+    }
+
+private:
+    static constexpr int steal_depth_bonus = 2;
+
+    void record(double cost)
+    {
+        // Exponential moving average; concurrent updates may overwrite each other, which is fine for a heuristic
+        double previous = ns_per_element.load(std::memory_order_relaxed);
+        double updated = previous <= 0.0 ? cost : previous + (cost - previous) / 8.0;
+        ns_per_element.store(updated, std::memory_order_relaxed);
+        leaves.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    double target_leaf_ns;
+    std::atomic<double> ns_per_element{0.0};
+    std::atomic<std::size_t> leaves{0};
+    std::atomic<std::size_t> steals{0};
+};
+
+namespace detail
+{
+    template <typename T, typename Leaf, typename Combine, typename Partitioner>
+    T reduce_range(ForkJoinPool& pool, std::size_t begin, std::size_t end, const T& identity,
+                   const Leaf& leaf, const Combine& combine, Partitioner& partitioner,
+                   typename Partitioner::State state)
+    {
+        std::size_t n = end - begin;
+        if (!partitioner.divisible(state, n))
+        {
+            return partitioner.run_leaf(leaf, begin, end);
+        }
+
+        auto split = partitioner.split(state, n);
+        std::size_t mid = begin + split.left_size;
+        T left = identity;
+        TaskGroup group;
+
+        // Fork: the left part may be stolen, the right part runs here
+        int spawner = pool.current_worker();
+        pool.spawn(group, [&, spawner, left_state = split.left]() mutable
+        {
+            if (pool.current_worker() != spawner) partitioner.stolen(left_state);
+            left = reduce_range(pool, begin, mid, identity, leaf, combine, partitioner, left_state);
+        });
+        T right = reduce_range(pool, mid, end, identity, leaf, combine, partitioner, split.right);
+
+        // Join: help with other work until the left part is done
+        pool.sync(group);
+        return combine(left, right);
+    }
+}
+
+// Divide-and-conquer reduction of [begin, end) on the pool, split as decided by the partitioner
+template <typename T, typename Leaf, typename Combine, typename Partitioner>
+    requires requires { typename std::remove_cvref_t<Partitioner>::State; }
+T parallel_reduce(ForkJoinPool& pool, std::size_t begin, std::size_t end, T identity,
+                  Leaf leaf, Combine combine, Partitioner&& partitioner)
+{
+    if (end <= begin) return identity;
+
+    auto root = [&]
+    {
+        auto state = partitioner.root(pool, end - begin);
+        return detail::reduce_range(pool, begin, end, identity, leaf, combine, partitioner, state);
+    };
+    if (pool.current_worker() >= 0)
+    {
+        return root();
+    }
+    return pool.invoke(root);
+}
+
+// Fixed cutoff: split until a range is not larger than grain
+template <typename T, typename Leaf, typename Combine>
+T parallel_reduce(ForkJoinPool& pool, std::size_t begin, std::size_t end, std::size_t grain,
+                  T identity, Leaf leaf, Combine combine)
+{
+    return parallel_reduce(pool, begin, end, identity, leaf, combine, SimplePartitioner(grain));
+}
@@ -0,0 +1,85 @@
+/*
+
+Sharded result buffer
+
+Appending every result to one std::vector behind one mutex turns the mutex into
+a convoy: all tasks queue on it, whatever the number of workers.
+
+ShardedBuffer<T> keeps one vector per shard, each behind its own mutex and on
+its own cache line. A thread always appends to the same shard, chosen from a
+per-thread index, so with at least as many shards as threads each lock is
+taken by one thread only and is never contended. merge() concatenates the
+shards once, when all producers are done.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class ShardedBuffer
+{
+public:
+    explicit ShardedBuffer(std::size_t numShards = 2 * std::max(1u, std::thread::hardware_concurrency()))
+        : shards(numShards ? numShards : 1)
+    {
+    }
+
+    ShardedBuffer(const ShardedBuffer&) = delete;
+    ShardedBuffer& operator=(const ShardedBuffer&) = delete;
+
+    void push(T value)
+    {
+        Shard& shard = shards[thread_index() % shards.size()];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        shard.items.push_back(std::move(value));
+    }
+
+    // Moves every item out, shard by shard. Call once the producers have finished.
+    std::vector<T> merge()
+    {
+        std::size_t total = 0;
+        for (Shard& shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            total += shard.items.size();
+        }
+
+        std::vector<T> result;
+        result.reserve(total);
+        for (Shard& shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            for (T& item : shard.items)
+            {
+                result.push_back(std::move(item));
+            }
+            shard.items.clear();
+        }
+        return result;
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        std::mutex mtx;
+        std::vector<T> items;
+    };
+
+    // Threads are numbered in the order they first push: consecutive workers get different shards
+    static std::size_t thread_index()
+    {
+        static std::atomic<std::size_t> next{0};
+        static thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+    std::vector<Shard> shards;
+};
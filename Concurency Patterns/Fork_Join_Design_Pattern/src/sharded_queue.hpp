@@ -0,0 +1,158 @@
+/*
+
+Sharded multi-producer / multi-consumer queue
+
+With one std::queue behind one mutex, every push and every pop of every thread
+goes through the same lock and the same cache line, and notify_one() costs a
+syscall on each push even when no consumer sleeps.
+
+ShardedQueue<T> splits the queue into shards, each a std::deque behind its own
+SpinLock on its own cache line:
+
+push(v)  : appends to the calling thread's home shard, so producers on
+           different shards never touch the same lock.
+try_pop  : pops from the home shard first, then steals from the other shards,
+           skipping the ones whose size counter says they are empty and the
+           ones whose lock is busy.
+pop()    : when every shard is empty, spins and yields for a short while, then
+           sleeps on an EventCount; returns std::nullopt once the queue is
+           closed and drained.
+close()  : wakes every consumer; items already pushed are still delivered.
+
+Order is FIFO per shard (per producer when there are enough shards), not global.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "event_count.hpp"
+#include "spin_lock.hpp"
+
+template <typename T>
+class ShardedQueue
+{
+public:
+    explicit ShardedQueue(std::size_t numShards = std::max(1u, std::thread::hardware_concurrency()))
+        : shards(numShards ? numShards : 1)
+    {
+    }
+
+    ShardedQueue(const ShardedQueue&) = delete;
+    ShardedQueue& operator=(const ShardedQueue&) = delete;
+
+    void push(T value)
+    {
+        Shard& shard = shards[home()];
+        {
+            std::lock_guard<SpinLock> lock(shard.lock);
+            shard.items.push_back(std::move(value));
+            shard.size.store(shard.items.size(), std::memory_order_relaxed);
+        }
+        events.notify_one(); // Only a load when no consumer sleeps
+    }
+
+    std::optional<T> try_pop()
+    {
+        std::size_t start = home();
+        for (std::size_t i = 0; i < shards.size(); ++i)
+        {
+            Shard& shard = shards[(start + i) % shards.size()];
+            if (shard.size.load(std::memory_order_relaxed) == 0) continue;
+
+            // Wait for the home shard, but do not queue on a busy shard of another thread
+            std::unique_lock<SpinLock> lock(shard.lock, std::defer_lock);
+            if (i == 0) lock.lock();
+            else if (!lock.try_lock()) continue;
+
+            if (std::optional<T> value = take(shard)) return value;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<T> pop()
+    {
+        while (true)
+        {
+            // Items usually arrive within a few microseconds under load: spin, then yield, then sleep
+            for (int round = 0; round < spin_rounds + yield_rounds; ++round)
+            {
+                if (std::optional<T> value = try_pop()) return value;
+                if (round < spin_rounds) cpu_relax();
+                else std::this_thread::yield();
+            }
+
+            EventCount::Key key = events.prepare_wait();
+            if (std::optional<T> value = try_pop_all())
+            {
+                events.cancel_wait();
+                return value;
+            }
+            if (closed.load(std::memory_order_seq_cst)) // seq_cst: pairs with the fence in notify_all
+            {
+                events.cancel_wait();
+                return std::nullopt;
+            }
+            events.wait(key);
+        }
+    }
+
+    void close()
+    {
+        closed.store(true, std::memory_order_release);
+        events.notify_all();
+    }
+
+private:
+    static constexpr int spin_rounds = 16;
+    static constexpr int yield_rounds = 8;
+
+    struct alignas(64) Shard
+    {
+        SpinLock lock;
+        std::atomic<std::size_t> size{0}; // read without the lock to skip empty shards
+        std::deque<T> items;
+    };
+
+    // Before sleeping, look at every shard, waiting for busy locks instead of skipping them
+    std::optional<T> try_pop_all()
+    {
+        for (Shard& shard : shards)
+        {
+            std::lock_guard<SpinLock> lock(shard.lock);
+            if (std::optional<T> value = take(shard)) return value;
+        }
+        return std::nullopt;
+    }
+
+    // Pops the front of a locked shard
+    static std::optional<T> take(Shard& shard)
+    {
+        if (shard.items.empty()) return std::nullopt;
+
+        std::optional<T> value(std::move(shard.items.front()));
+        shard.items.pop_front();
+        shard.size.store(shard.items.size(), std::memory_order_relaxed);
+        return value;
+    }
+
+    // Threads are numbered in the order they first use a queue; consecutive threads get different shards
+    std::size_t home() const
+    {
+        static std::atomic<std::size_t> next{0};
+        static thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index % shards.size();
+    }
+
+    std::vector<Shard> shards;
+    EventCount events;
+    std::atomic<bool> closed{false};
+};
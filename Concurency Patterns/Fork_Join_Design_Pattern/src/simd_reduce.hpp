@@ -0,0 +1,781 @@
+/*
+
+SIMD leaf kernels for fork-join reductions
+
+sum / min / max / dot over int32, int64, float and double, compiled for
+SSE2, AVX2 and AVX-512 and selected at runtime from what the CPU supports.
+The same algorithms (simd_reduce_generic.inc) are compiled once per
+instruction set; only the small per-type traits differ.
+
+Accumulation:
+- int32 sum and dot accumulate in 64-bit lanes: the sum of up to 2^32 int32
+  values cannot overflow, unlike the scalar "int sum += arr[i]" loop.
+- int64 sum and every dot wrap modulo 2^64, like the plain loop would on
+  hardware. sum_wide() returns the exact int64 sum as __int128 and
+  sum_checked() throws std::overflow_error when it does not fit in int64.
+- float and double sum/dot take a FloatSum mode:
+    Fast     : several vector accumulators, error grows with n
+    Pairwise : vector sums of short blocks combined as a tree (default)
+    Kahan    : compensated summation per lane, most accurate, slower
+
+min/max of an empty range return the identity (max()/infinity for min,
+lowest()/-infinity for max). NaNs are not propagated.
+
+set_isa() lowers the instruction set in use, e.g. to compare the paths in a
+benchmark; it never raises it above what detected_isa() reports.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_REDUCE_X86 1
+#endif
+
+namespace simd
+{
+    enum class Isa
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512
+    };
+
+    enum class FloatSum
+    {
+        Fast,
+        Pairwise,
+        Kahan
+    };
+
+    inline const char* isa_name(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::SSE2: return "sse2";
+            case Isa::AVX2: return "avx2";
+            case Isa::AVX512: return "avx512";
+            default: return "scalar";
+        }
+    }
+
+    template <typename Elem>
+    constexpr Elem identity_min()
+    {
+        return std::numeric_limits<Elem>::has_infinity ? std::numeric_limits<Elem>::infinity()
+                                                       : std::numeric_limits<Elem>::max();
+    }
+
+    template <typename Elem>
+    constexpr Elem identity_max()
+    {
+        return std::numeric_limits<Elem>::has_infinity ? -std::numeric_limits<Elem>::infinity()
+                                                       : std::numeric_limits<Elem>::lowest();
+    }
+
+    // ------------------------------------------------------------------
+    // Scalar fallback: one element per step, still with 4 accumulators
+    // ------------------------------------------------------------------
+    namespace scalar
+    {
+        template <typename E, typename A>
+        struct Traits
+        {
+            using Elem = E;
+            using Acc = A;
+            using V = A;
+            using M = E;
+            static constexpr std::size_t step = 1;
+            static constexpr std::size_t lanes = 1;
+
+            static V zero() { return V(0); }
+            static V add(V a, V b) { return a + b; }
+            static V sub(V a, V b) { return a - b; }
+            static V mul(V a, V b) { return a * b; }
+            static V add_block(V acc, const E* p) { return acc + static_cast<A>(*p); }
+            static V add_product(V acc, const E* a, const E* b) { return acc + static_cast<A>(*a) * static_cast<A>(*b); }
+            static A reduce_add(V v) { return v; }
+            static void store(E* p, V v) { *p = static_cast<E>(v); }
+
+            static M load(const E* p) { return *p; }
+            static M vmin(M a, M b) { return std::min(a, b); }
+            static M vmax(M a, M b) { return std::max(a, b); }
+            static E reduce_min(M m) { return m; }
+            static E reduce_max(M m) { return m; }
+
+            static void add_split(V& hi, V& lo, V& neg, const E* p)
+            {
+                std::uint64_t x = static_cast<std::uint64_t>(*p);
+                hi += x >> 32;
+                lo += x & 0xffffffffu;
+                neg += x >> 63;
+            }
+        };
+
+        using F32 = Traits<float, float>;
+        using F64 = Traits<double, double>;
+        using I32 = Traits<std::int32_t, std::uint64_t>;
+        using I64 = Traits<std::int64_t, std::uint64_t>;
+
+#include "simd_reduce_generic.inc"
+    }
+
+#ifdef SIMD_REDUCE_X86
+
+    // Helpers to reduce a vector through memory; only used once per kernel call
+    template <typename E, std::size_t N, typename Store>
+    E fold_lanes(Store store, E init, E (*op)(E, E))
+    {
+        E lanes[N];
+        store(lanes);
+        E result = init;
+        for (std::size_t i = 0; i < N; ++i) result = op(result, lanes[i]);
+        return result;
+    }
+
+    template <typename E> E op_add(E a, E b) { return a + b; }
+    template <typename E> E op_min(E a, E b) { return std::min(a, b); }
+    template <typename E> E op_max(E a, E b) { return std::max(a, b); }
+
+    // ------------------------------------------------------------------
+    // SSE2: 128-bit vectors, baseline of every x86-64 CPU
+    // ------------------------------------------------------------------
+#pragma GCC push_options
+#pragma GCC target("sse2")
+    namespace sse2
+    {
+        struct F32
+        {
+            using Elem = float;
+            using Acc = float;
+            using V = __m128;
+            using M = __m128;
+            static constexpr std::size_t step = 4;
+            static constexpr std::size_t lanes = 4;
+
+            static V zero() { return _mm_setzero_ps(); }
+            static V load(const float* p) { return _mm_loadu_ps(p); }
+            static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+            static V add(V a, V b) { return _mm_add_ps(a, b); }
+            static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+            static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+            static V add_block(V acc, const float* p) { return _mm_add_ps(acc, load(p)); }
+            static V add_product(V acc, const float* a, const float* b) { return _mm_add_ps(acc, _mm_mul_ps(load(a), load(b))); }
+            static M vmin(M a, M b) { return _mm_min_ps(a, b); }
+            static M vmax(M a, M b) { return _mm_max_ps(a, b); }
+            static float reduce_add(V v) { return fold_lanes<float, 4>([&](float* p) { store(p, v); }, 0.0f, op_add<float>); }
+            static float reduce_min(M m) { return fold_lanes<float, 4>([&](float* p) { store(p, m); }, identity_min<float>(), op_min<float>); }
+            static float reduce_max(M m) { return fold_lanes<float, 4>([&](float* p) { store(p, m); }, identity_max<float>(), op_max<float>); }
+        };
+
+        struct F64
+        {
+            using Elem = double;
+            using Acc = double;
+            using V = __m128d;
+            using M = __m128d;
+            static constexpr std::size_t step = 2;
+            static constexpr std::size_t lanes = 2;
+
+            static V zero() { return _mm_setzero_pd(); }
+            static V load(const double* p) { return _mm_loadu_pd(p); }
+            static void store(double* p, V v) { _mm_storeu_pd(p, v); }
+            static V add(V a, V b) { return _mm_add_pd(a, b); }
+            static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+            static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+            static V add_block(V acc, const double* p) { return _mm_add_pd(acc, load(p)); }
+            static V add_product(V acc, const double* a, const double* b) { return _mm_add_pd(acc, _mm_mul_pd(load(a), load(b))); }
+            static M vmin(M a, M b) { return _mm_min_pd(a, b); }
+            static M vmax(M a, M b) { return _mm_max_pd(a, b); }
+            static double reduce_add(V v) { return fold_lanes<double, 2>([&](double* p) { store(p, v); }, 0.0, op_add<double>); }
+            static double reduce_min(M m) { return fold_lanes<double, 2>([&](double* p) { store(p, m); }, identity_min<double>(), op_min<double>); }
+            static double reduce_max(M m) { return fold_lanes<double, 2>([&](double* p) { store(p, m); }, identity_max<double>(), op_max<double>); }
+        };
+
+        // Shared by I32 and I64: 64-bit lane helpers SSE2 does not provide
+        struct Int64Lanes
+        {
+            // Signed 32x32->64 multiply of the low half of each 64-bit lane (_mm_mul_epi32 is SSE4.1)
+            static __m128i mul_epi32(__m128i a, __m128i b)
+            {
+                __m128i product = _mm_mul_epu32(a, b);
+                __m128i fix = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b),
+                                            _mm_and_si128(_mm_srai_epi32(b, 31), a));
+                return _mm_sub_epi64(product, _mm_slli_epi64(fix, 32));
+            }
+
+            // Low 64 bits of a 64x64 multiply
+            static __m128i mullo_epi64(__m128i a, __m128i b)
+            {
+                __m128i low = _mm_mul_epu32(a, b);
+                __m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), b),
+                                              _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+                return _mm_add_epi64(low, _mm_slli_epi64(cross, 32));
+            }
+
+            // Signed 64-bit a > b (_mm_cmpgt_epi64 is SSE4.2)
+            static __m128i cmpgt_epi64(__m128i a, __m128i b)
+            {
+                __m128i r = _mm_and_si128(_mm_cmpeq_epi32(a, b), _mm_sub_epi64(b, a));
+                r = _mm_or_si128(r, _mm_cmpgt_epi32(a, b));
+                return _mm_shuffle_epi32(_mm_srai_epi32(r, 31), _MM_SHUFFLE(3, 3, 1, 1));
+            }
+
+            static __m128i select(__m128i mask, __m128i a, __m128i b)
+            {
+                return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+            }
+
+            static std::uint64_t reduce_add(__m128i v)
+            {
+                return fold_lanes<std::uint64_t, 2>([&](std::uint64_t* p) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); },
+                                                    0, op_add<std::uint64_t>);
+            }
+        };
+
+        struct I32 : Int64Lanes
+        {
+            using Elem = std::int32_t;
+            using Acc = std::uint64_t;
+            using V = __m128i;
+            using M = __m128i;
+            static constexpr std::size_t step = 4;
+            static constexpr std::size_t lanes = 4;
+
+            static V zero() { return _mm_setzero_si128(); }
+            static M load(const std::int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+            static V add(V a, V b) { return _mm_add_epi64(a, b); }
+
+            static V add_block(V acc, const std::int32_t* p)
+            {
+                // Sign-extend four int32 to int64 (_mm_cvtepi32_epi64 is SSE4.1)
+                M x = load(p);
+                M sign = _mm_srai_epi32(x, 31);
+                return _mm_add_epi64(acc, _mm_add_epi64(_mm_unpacklo_epi32(x, sign), _mm_unpackhi_epi32(x, sign)));
+            }
+
+            static V add_product(V acc, const std::int32_t* a, const std::int32_t* b)
+            {
+                M x = load(a), y = load(b);
+                V even = mul_epi32(x, y);
+                V odd = mul_epi32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+                return _mm_add_epi64(acc, _mm_add_epi64(even, odd));
+            }
+
+            static M vmin(M a, M b) { return select(_mm_cmpgt_epi32(a, b), b, a); }
+            static M vmax(M a, M b) { return select(_mm_cmpgt_epi32(a, b), a, b); }
+
+            static std::int32_t reduce_min(M m)
+            {
+                return fold_lanes<std::int32_t, 4>([&](std::int32_t* p) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), m); },
+                                                   identity_min<std::int32_t>(), op_min<std::int32_t>);
+            }
+
+            static std::int32_t reduce_max(M m)
+            {
+                return fold_lanes<std::int32_t, 4>([&](std::int32_t* p) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), m); },
+                                                   identity_max<std::int32_t>(), op_max<std::int32_t>);
+            }
+        };
+
+        struct I64 : Int64Lanes
+        {
+            using Elem = std::int64_t;
+            using Acc = std::uint64_t;
+            using V = __m128i;
+            using M = __m128i;
+            static constexpr std::size_t step = 2;
+            static constexpr std::size_t lanes = 2;
+
+            static V zero() { return _mm_setzero_si128(); }
+            static M load(const std::int64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+            static V add(V a, V b) { return _mm_add_epi64(a, b); }
+            static V add_block(V acc, const std::int64_t* p) { return _mm_add_epi64(acc, load(p)); }
+            static V add_product(V acc, const std::int64_t* a, const std::int64_t* b) { return _mm_add_epi64(acc, mullo_epi64(load(a), load(b))); }
+
+            static void add_split(V& hi, V& lo, V& neg, const std::int64_t* p)
+            {
+                M x = load(p);
+                hi = _mm_add_epi64(hi, _mm_srli_epi64(x, 32));
+                lo = _mm_add_epi64(lo, _mm_and_si128(x, _mm_set1_epi64x(0xffffffff)));
+                neg = _mm_add_epi64(neg, _mm_srli_epi64(x, 63));
+            }
+
+            static M vmin(M a, M b) { return select(cmpgt_epi64(a, b), b, a); }
+            static M vmax(M a, M b) { return select(cmpgt_epi64(a, b), a, b); }
+
+            static std::int64_t reduce_min(M m)
+            {
+                return fold_lanes<std::int64_t, 2>([&](std::int64_t* p) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), m); },
+                                                   identity_min<std::int64_t>(), op_min<std::int64_t>);
+            }
+
+            static std::int64_t reduce_max(M m)
+            {
+                return fold_lanes<std::int64_t, 2>([&](std::int64_t* p) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), m); },
+                                                   identity_max<std::int64_t>(), op_max<std::int64_t>);
+            }
+        };
+
+#include "simd_reduce_generic.inc"
+    }
+#pragma GCC pop_options
+
+    // ------------------------------------------------------------------
+    // AVX2: 256-bit vectors
+    // ------------------------------------------------------------------
+#pragma GCC push_options
+#pragma GCC target("avx2")
+    namespace avx2
+    {
+        struct F32
+        {
+            using Elem = float;
+            using Acc = float;
+            using V = __m256;
+            using M = __m256;
+            static constexpr std::size_t step = 8;
+            static constexpr std::size_t lanes = 8;
+
+            static V zero() { return _mm256_setzero_ps(); }
+            static V load(const float* p) { return _mm256_loadu_ps(p); }
+            static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+            static V add(V a, V b) { return _mm256_add_ps(a, b); }
+            static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+            static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+            static V add_block(V acc, const float* p) { return _mm256_add_ps(acc, load(p)); }
+            static V add_product(V acc, const float* a, const float* b) { return _mm256_add_ps(acc, _mm256_mul_ps(load(a), load(b))); }
+            static M vmin(M a, M b) { return _mm256_min_ps(a, b); }
+            static M vmax(M a, M b) { return _mm256_max_ps(a, b); }
+            static float reduce_add(V v) { return fold_lanes<float, 8>([&](float* p) { store(p, v); }, 0.0f, op_add<float>); }
+            static float reduce_min(M m) { return fold_lanes<float, 8>([&](float* p) { store(p, m); }, identity_min<float>(), op_min<float>); }
+            static float reduce_max(M m) { return fold_lanes<float, 8>([&](float* p) { store(p, m); }, identity_max<float>(), op_max<float>); }
+        };
+
+        struct F64
+        {
+            using Elem = double;
+            using Acc = double;
+            using V = __m256d;
+            using M = __m256d;
+            static constexpr std::size_t step = 4;
+            static constexpr std::size_t lanes = 4;
+
+            static V zero() { return _mm256_setzero_pd(); }
+            static V load(const double* p) { return _mm256_loadu_pd(p); }
+            static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+            static V add(V a, V b) { return _mm256_add_pd(a, b); }
+            static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+            static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+            static V add_block(V acc, const double* p) { return _mm256_add_pd(acc, load(p)); }
+            static V add_product(V acc, const double* a, const double* b) { return _mm256_add_pd(acc, _mm256_mul_pd(load(a), load(b))); }
+            static M vmin(M a, M b) { return _mm256_min_pd(a, b); }
+            static M vmax(M a, M b) { return _mm256_max_pd(a, b); }
+            static double reduce_add(V v) { return fold_lanes<double, 4>([&](double* p) { store(p, v); }, 0.0, op_add<double>); }
+            static double reduce_min(M m) { return fold_lanes<double, 4>([&](double* p) { store(p, m); }, identity_min<double>(), op_min<double>); }
+            static double reduce_max(M m) { return fold_lanes<double, 4>([&](double* p) { store(p, m); }, identity_max<double>(), op_max<double>); }
+        };
+
+        struct Int64Lanes
+        {
+            static __m256i mullo_epi64(__m256i a, __m256i b)
+            {
+                __m256i low = _mm256_mul_epu32(a, b);
+                __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                                 _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+                return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+            }
+
+            static std::uint64_t reduce_add(__m256i v)
+            {
+                return fold_lanes<std::uint64_t, 4>([&](std::uint64_t* p) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); },
+                                                    0, op_add<std::uint64_t>);
+            }
+        };
+
+        struct I32 : Int64Lanes
+        {
+            using Elem = std::int32_t;
+            using Acc = std::uint64_t;
+            using V = __m256i;
+            using M = __m256i;
+            static constexpr std::size_t step = 8;
+            static constexpr std::size_t lanes = 8;
+
+            static V zero() { return _mm256_setzero_si256(); }
+            static M load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+            static V add(V a, V b) { return _mm256_add_epi64(a, b); }
+
+            static V add_block(V acc, const std::int32_t* p)
+            {
+                M x = load(p);
+                V lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x));
+                V hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1));
+                return _mm256_add_epi64(acc, _mm256_add_epi64(lo, hi));
+            }
+
+            static V add_product(V acc, const std::int32_t* a, const std::int32_t* b)
+            {
+                M x = load(a), y = load(b);
+                V even = _mm256_mul_epi32(x, y);
+                V odd = _mm256_mul_epi32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32));
+                return _mm256_add_epi64(acc, _mm256_add_epi64(even, odd));
+            }
+
+            static M vmin(M a, M b) { return _mm256_min_epi32(a, b); }
+            static M vmax(M a, M b) { return _mm256_max_epi32(a, b); }
+
+            static std::int32_t reduce_min(M m)
+            {
+                return fold_lanes<std::int32_t, 8>([&](std::int32_t* p) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), m); },
+                                                   identity_min<std::int32_t>(), op_min<std::int32_t>);
+            }
+
+            static std::int32_t reduce_max(M m)
+            {
+                return fold_lanes<std::int32_t, 8>([&](std::int32_t* p) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), m); },
+                                                   identity_max<std::int32_t>(), op_max<std::int32_t>);
+            }
+        };
+
+        struct I64 : Int64Lanes
+        {
+            using Elem = std::int64_t;
+            using Acc = std::uint64_t;
+            using V = __m256i;
+            using M = __m256i;
+            static constexpr std::size_t step = 4;
+            static constexpr std::size_t lanes = 4;
+
+            static V zero() { return _mm256_setzero_si256(); }
+            static M load(const std::int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+            static V add(V a, V b) { return _mm256_add_epi64(a, b); }
+            static V add_block(V acc, const std::int64_t* p) { return _mm256_add_epi64(acc, load(p)); }
+            static V add_product(V acc, const std::int64_t* a, const std::int64_t* b) { return _mm256_add_epi64(acc, mullo_epi64(load(a), load(b))); }
+
+            static void add_split(V& hi, V& lo, V& neg, const std::int64_t* p)
+            {
+                M x = load(p);
+                hi = _mm256_add_epi64(hi, _mm256_srli_epi64(x, 32));
+                lo = _mm256_add_epi64(lo, _mm256_and_si256(x, _mm256_set1_epi64x(0xffffffff)));
+                neg = _mm256_add_epi64(neg, _mm256_srli_epi64(x, 63));
+            }
+
+            static M vmin(M a, M b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+            static M vmax(M a, M b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+
+            static std::int64_t reduce_min(M m)
+            {
+                return fold_lanes<std::int64_t, 4>([&](std::int64_t* p) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), m); },
+                                                   identity_min<std::int64_t>(), op_min<std::int64_t>);
+            }
+
+            static std::int64_t reduce_max(M m)
+            {
+                return fold_lanes<std::int64_t, 4>([&](std::int64_t* p) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), m); },
+                                                   identity_max<std::int64_t>(), op_max<std::int64_t>);
+            }
+        };
+
+#include "simd_reduce_generic.inc"
+    }
+#pragma GCC pop_options
+
+    // ------------------------------------------------------------------
+    // AVX-512 (foundation subset only): 512-bit vectors
+    // ------------------------------------------------------------------
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized" // GCC 12 false positive in avx512fintrin.h (PR 105593)
+    namespace avx512
+    {
+        struct F32
+        {
+            using Elem = float;
+            using Acc = float;
+            using V = __m512;
+            using M = __m512;
+            static constexpr std::size_t step = 16;
+            static constexpr std::size_t lanes = 16;
+
+            static V zero() { return _mm512_setzero_ps(); }
+            static V load(const float* p) { return _mm512_loadu_ps(p); }
+            static void store(float* p, V v) { _mm512_storeu_ps(p, v); }
+            static V add(V a, V b) { return _mm512_add_ps(a, b); }
+            static V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+            static V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+            static V add_block(V acc, const float* p) { return _mm512_add_ps(acc, load(p)); }
+            static V add_product(V acc, const float* a, const float* b) { return _mm512_add_ps(acc, _mm512_mul_ps(load(a), load(b))); }
+            static M vmin(M a, M b) { return _mm512_min_ps(a, b); }
+            static M vmax(M a, M b) { return _mm512_max_ps(a, b); }
+            static float reduce_add(V v) { return fold_lanes<float, 16>([&](float* p) { store(p, v); }, 0.0f, op_add<float>); }
+            static float reduce_min(M m) { return fold_lanes<float, 16>([&](float* p) { store(p, m); }, identity_min<float>(), op_min<float>); }
+            static float reduce_max(M m) { return fold_lanes<float, 16>([&](float* p) { store(p, m); }, identity_max<float>(), op_max<float>); }
+        };
+
+        struct F64
+        {
+            using Elem = double;
+            using Acc = double;
+            using V = __m512d;
+            using M = __m512d;
+            static constexpr std::size_t step = 8;
+            static constexpr std::size_t lanes = 8;
+
+            static V zero() { return _mm512_setzero_pd(); }
+            static V load(const double* p) { return _mm512_loadu_pd(p); }
+            static void store(double* p, V v) { _mm512_storeu_pd(p, v); }
+            static V add(V a, V b) { return _mm512_add_pd(a, b); }
+            static V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+            static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+            static V add_block(V acc, const double* p) { return _mm512_add_pd(acc, load(p)); }
+            static V add_product(V acc, const double* a, const double* b) { return _mm512_add_pd(acc, _mm512_mul_pd(load(a), load(b))); }
+            static M vmin(M a, M b) { return _mm512_min_pd(a, b); }
+            static M vmax(M a, M b) { return _mm512_max_pd(a, b); }
+            static double reduce_add(V v) { return fold_lanes<double, 8>([&](double* p) { store(p, v); }, 0.0, op_add<double>); }
+            static double reduce_min(M m) { return fold_lanes<double, 8>([&](double* p) { store(p, m); }, identity_min<double>(), op_min<double>); }
+            static double reduce_max(M m) { return fold_lanes<double, 8>([&](double* p) { store(p, m); }, identity_max<double>(), op_max<double>); }
+        };
+
+        struct Int64Lanes
+        {
+            // _mm512_mullo_epi64 needs AVX-512DQ, so the product is built from 32-bit halves
+            static __m512i mullo_epi64(__m512i a, __m512i b)
+            {
+                __m512i low = _mm512_mul_epu32(a, b);
+                __m512i cross = _mm512_add_epi64(_mm512_mul_epu32(_mm512_srli_epi64(a, 32), b),
+                                                 _mm512_mul_epu32(a, _mm512_srli_epi64(b, 32)));
+                return _mm512_add_epi64(low, _mm512_slli_epi64(cross, 32));
+            }
+
+            static std::uint64_t reduce_add(__m512i v)
+            {
+                return fold_lanes<std::uint64_t, 8>([&](std::uint64_t* p) { _mm512_storeu_si512(p, v); },
+                                                    0, op_add<std::uint64_t>);
+            }
+        };
+
+        struct I32 : Int64Lanes
+        {
+            using Elem = std::int32_t;
+            using Acc = std::uint64_t;
+            using V = __m512i;
+            using M = __m512i;
+            static constexpr std::size_t step = 16;
+            static constexpr std::size_t lanes = 16;
+
+            static V zero() { return _mm512_setzero_si512(); }
+            static M load(const std::int32_t* p) { return _mm512_loadu_si512(p); }
+            static V add(V a, V b) { return _mm512_add_epi64(a, b); }
+
+            static V add_block(V acc, const std::int32_t* p)
+            {
+                // Two 256-bit loads sign-extended to 8 x int64 each
+                V lo = _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+                V hi = _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8)));
+                return _mm512_add_epi64(acc, _mm512_add_epi64(lo, hi));
+            }
+
+            static V add_product(V acc, const std::int32_t* a, const std::int32_t* b)
+            {
+                M x = load(a), y = load(b);
+                V even = _mm512_mul_epi32(x, y);
+                V odd = _mm512_mul_epi32(_mm512_srli_epi64(x, 32), _mm512_srli_epi64(y, 32));
+                return _mm512_add_epi64(acc, _mm512_add_epi64(even, odd));
+            }
+
+            static M vmin(M a, M b) { return _mm512_min_epi32(a, b); }
+            static M vmax(M a, M b) { return _mm512_max_epi32(a, b); }
+
+            static std::int32_t reduce_min(M m)
+            {
+                return fold_lanes<std::int32_t, 16>([&](std::int32_t* p) { _mm512_storeu_si512(p, m); },
+                                                    identity_min<std::int32_t>(), op_min<std::int32_t>);
+            }
+
+            static std::int32_t reduce_max(M m)
+            {
+                return fold_lanes<std::int32_t, 16>([&](std::int32_t* p) { _mm512_storeu_si512(p, m); },
+                                                    identity_max<std::int32_t>(), op_max<std::int32_t>);
+            }
+        };
+
+        struct I64 : Int64Lanes
+        {
+            using Elem = std::int64_t;
+            using Acc = std::uint64_t;
+            using V = __m512i;
+            using M = __m512i;
+            static constexpr std::size_t step = 8;
+            static constexpr std::size_t lanes = 8;
+
+            static V zero() { return _mm512_setzero_si512(); }
+            static M load(const std::int64_t* p) { return _mm512_loadu_si512(p); }
+            static V add(V a, V b) { return _mm512_add_epi64(a, b); }
+            static V add_block(V acc, const std::int64_t* p) { return _mm512_add_epi64(acc, load(p)); }
+            static V add_product(V acc, const std::int64_t* a, const std::int64_t* b) { return _mm512_add_epi64(acc, mullo_epi64(load(a), load(b))); }
+
+            static void add_split(V& hi, V& lo, V& neg, const std::int64_t* p)
+            {
+                M x = load(p);
+                hi = _mm512_add_epi64(hi, _mm512_srli_epi64(x, 32));
+                lo = _mm512_add_epi64(lo, _mm512_and_si512(x, _mm512_set1_epi64(0xffffffff)));
+                neg = _mm512_add_epi64(neg, _mm512_srli_epi64(x, 63));
+            }
+
+            static M vmin(M a, M b) { return _mm512_min_epi64(a, b); }
+            static M vmax(M a, M b) { return _mm512_max_epi64(a, b); }
+
+            static std::int64_t reduce_min(M m)
+            {
+                return fold_lanes<std::int64_t, 8>([&](std::int64_t* p) { _mm512_storeu_si512(p, m); },
+                                                   identity_min<std::int64_t>(), op_min<std::int64_t>);
+            }
+
+            static std::int64_t reduce_max(M m)
+            {
+                return fold_lanes<std::int64_t, 8>([&](std::int64_t* p) { _mm512_storeu_si512(p, m); },
+                                                   identity_max<std::int64_t>(), op_max<std::int64_t>);
+            }
+        };
+
+#include "simd_reduce_generic.inc"
+    }
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+#endif // SIMD_REDUCE_X86
+
+    // ------------------------------------------------------------------
+    // Runtime dispatch
+    // ------------------------------------------------------------------
+    inline Isa detected_isa()
+    {
+#ifdef SIMD_REDUCE_X86
+        static const Isa isa = []
+        {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) return Isa::AVX512;
+            if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+            if (__builtin_cpu_supports("sse2")) return Isa::SSE2;
+            return Isa::Scalar;
+        }();
+        return isa;
+#else
+        return Isa::Scalar;
+#endif
+    }
+
+    namespace detail
+    {
+        inline std::atomic<Isa>& isa_override()
+        {
+            static std::atomic<Isa> isa{detected_isa()};
+            return isa;
+        }
+
+        // Calls f with the Kernels of the active instruction set
+        template <typename F>
+        decltype(auto) with_kernels(F&& f)
+        {
+            switch (isa_override().load(std::memory_order_relaxed))
+            {
+#ifdef SIMD_REDUCE_X86
+                case Isa::AVX512: return f(avx512::Kernels{});
+                case Isa::AVX2: return f(avx2::Kernels{});
+                case Isa::SSE2: return f(sse2::Kernels{});
+#endif
+                default: return f(scalar::Kernels{});
+            }
+        }
+    }
+
+    inline Isa active_isa() { return detail::isa_override().load(std::memory_order_relaxed); }
+
+    inline void set_isa(Isa isa)
+    {
+        detail::isa_override().store(std::min(isa, detected_isa()), std::memory_order_relaxed);
+    }
+
+    // int32 values are summed in 64-bit lanes: exact for up to 2^32 elements
+    inline std::int64_t sum(const std::int32_t* data, std::size_t n)
+    {
+        return static_cast<std::int64_t>(detail::with_kernels([&](auto k) { return k.sum(data, n); }));
+    }
+
+    // Wraps modulo 2^64 on overflow, see sum_wide() and sum_checked()
+    inline std::int64_t sum(const std::int64_t* data, std::size_t n)
+    {
+        return static_cast<std::int64_t>(detail::with_kernels([&](auto k) { return k.sum(data, n); }));
+    }
+
+    // Exact sum of up to 2^63 int64 values
+    inline __int128 sum_wide(const std::int64_t* data, std::size_t n)
+    {
+        return detail::with_kernels([&](auto k) { return k.sum_wide(data, n); });
+    }
+
+    inline std::int64_t sum_checked(const std::int64_t* data, std::size_t n)
+    {
+        __int128 total = sum_wide(data, n);
+        if (total > std::numeric_limits<std::int64_t>::max() || total < std::numeric_limits<std::int64_t>::min())
+        {
+            throw std::overflow_error("int64 sum overflows");
+        }
+        return static_cast<std::int64_t>(total);
+    }
+
+    inline float sum(const float* data, std::size_t n, FloatSum mode = FloatSum::Pairwise)
+    {
+        return detail::with_kernels([&](auto k) { return k.sum_float(data, n, mode); });
+    }
+
+    inline double sum(const double* data, std::size_t n, FloatSum mode = FloatSum::Pairwise)
+    {
+        return detail::with_kernels([&](auto k) { return k.sum_float(data, n, mode); });
+    }
+
+    // Products of int32 are exact in 64 bits; the running sum wraps modulo 2^64
+    inline std::int64_t dot(const std::int32_t* a, const std::int32_t* b, std::size_t n)
+    {
+        return static_cast<std::int64_t>(detail::with_kernels([&](auto k) { return k.dot(a, b, n); }));
+    }
+
+    inline std::int64_t dot(const std::int64_t* a, const std::int64_t* b, std::size_t n)
+    {
+        return static_cast<std::int64_t>(detail::with_kernels([&](auto k) { return k.dot(a, b, n); }));
+    }
+
+    inline float dot(const float* a, const float* b, std::size_t n, FloatSum mode = FloatSum::Pairwise)
+    {
+        return detail::with_kernels([&](auto k) { return k.dot_float(a, b, n, mode); });
+    }
+
+    inline double dot(const double* a, const double* b, std::size_t n, FloatSum mode = FloatSum::Pairwise)
+    {
+        return detail::with_kernels([&](auto k) { return k.dot_float(a, b, n, mode); });
+    }
+
+    template <typename Elem>
+    Elem min(const Elem* data, std::size_t n)
+    {
+        return detail::with_kernels([&](auto k) { return k.min(data, n); });
+    }
+
+    template <typename Elem>
+    Elem max(const Elem* data, std::size_t n)
+    {
+        return detail::with_kernels([&](auto k) { return k.max(data, n); });
+    }
+}
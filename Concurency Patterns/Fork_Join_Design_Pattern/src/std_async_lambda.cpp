@@ -4,7 +4,7 @@
 int main()
 {
     // Lambda function to compute the square of a number
-    auto compute_square =  {
+    auto compute_square = [](int x) {
         return x * x;
     };
 
@@ -3,91 +3,101 @@
 Detailed Explanation
 Shared Resources:
 
-data_queue: A queue to hold the produced data.
-queue_mutex: A mutex to protect access to the queue.
-data_cond: A condition variable to synchronize the producer and consumer.
+data_queue: A sharded queue to hold the produced data (sharded_queue.hpp).
+Each producer pushes to its own shard under its own spin lock, consumers steal
+from the other shards when theirs is empty, so there is no single queue_mutex.
+Waiting consumers sleep on an event count instead of a condition variable.
 Producer Function:
 
 The producer generates data and pushes it into the queue.
-After adding data to the queue, it notifies the consumer using data_cond.notify_one().
+push() only wakes a consumer when one is actually sleeping, so a busy
+consumer costs the producer no notify_one() syscall.
 Consumer Function:
 
-The consumer waits for data to be available in the queue using data_cond.wait().
-Once data is available, it processes the data and removes it from the queue.
-The consumer exits when it encounters a special value (-1 in this case).
+The consumer waits for data to be available in the queue using pop().
+Once data is available, it processes it.
+The consumer exits when pop() returns no value: the queue is closed and empty.
 Main Function:
 
-The producer and consumer functions are launched asynchronously using std::async.
-The main function waits for the producer to finish and then signals the consumer to exit by pushing a special value into the queue and notifying the consumer.
+The producers and consumers are launched asynchronously using std::async.
+The main function waits for the producers to finish and then closes the queue,
+which wakes every consumer; they drain what is left and exit.
 Key Points
-Condition Variables: Used to block the consumer until data is available in the queue.
-Mutex: Ensures that access to the shared queue is thread-safe.
-Notification: The producer notifies the consumer when new data is available, and the main function notifies the consumer to exit.
-This example demonstrates how to use condition variables with std::async to synchronize tasks and manage shared resources efficiently. Would you like to explore more advanced synchronization techniques or specific use cases?
+Sharding: Producers and consumers rarely touch the same lock or cache line.
+Event count: Consumers sleep (futex) only after checking every shard, and
+producers skip the wake-up when nobody sleeps.
+Close instead of a special value: One close() ends any number of consumers.
 
 */
 
 
 #include <iostream>
-#include <queue>
 #include <future>
-#include <mutex>
-#include <condition_variable>
+#include <sstream>
+#include <vector>
+#include "sharded_queue.hpp"
 
 // Shared resources
-std::queue<int> data_queue;
-std::mutex queue_mutex;
-std::condition_variable data_cond;
+ShardedQueue<int> data_queue;
 
 // Producer function
-void producer(int count)
+void producer(int id, int count)
 {
     for (int i = 0; i < count; ++i)
     {
         std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Simulate work
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        data_queue.push(i);
-        std::cout << "Produced: " << i << std::endl;
-        data_cond.notify_one(); // Notify the consumer
+        int data = id * 100 + i;
+        data_queue.push(data);
+
+        std::ostringstream line;
+        line << "Producer " << id << " produced: " << data << "\n";
+        std::cout << line.str();
     }
 }
 
 // Consumer function
 void consumer(int id)
 {
-    while (true)
+    // Wait for data; no value means the queue is closed and drained
+    while (std::optional<int> data = data_queue.pop())
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        data_cond.wait(lock, [] { return !data_queue.empty(); }); // Wait for data
-
-        int data = data_queue.front();
-        data_queue.pop();
-        lock.unlock();
-
-        std::cout << "Consumer " << id << " processed: " << data << std::endl;
-
-        if (data == -1) break; // Exit condition
+        std::ostringstream line;
+        line << "Consumer " << id << " processed: " << *data << "\n";
+        std::cout << line.str();
     }
 }
 
 int main()
 {
-    // Launch producer and consumer asynchronously
-    auto producer_future = std::async(std::launch::async, producer, 10);
-    auto consumer_future = std::async(std::launch::async, consumer, 1);
+    const int numProducers = 2;
+    const int numConsumers = 2;
 
-    // Wait for the producer to finish
-    producer_future.get();
+    // Launch producers and consumers asynchronously
+    std::vector<std::future<void>> producers;
+    std::vector<std::future<void>> consumers;
+    for (int i = 0; i < numProducers; ++i)
+    {
+        producers.push_back(std::async(std::launch::async, producer, i, 10));
+    }
+    for (int i = 0; i < numConsumers; ++i)
+    {
+        consumers.push_back(std::async(std::launch::async, consumer, i));
+    }
 
-    // Signal the consumer to exit
+    // Wait for the producers to finish
+    for (auto& f : producers)
     {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        data_queue.push(-1); // Special value to signal exit
-        data_cond.notify_one();
+        f.get();
     }
 
-    // Wait for the consumer to finish
-    consumer_future.get();
+    // Signal the consumers to exit once the queue is drained
+    data_queue.close();
+
+    // Wait for the consumers to finish
+    for (auto& f : consumers)
+    {
+        f.get();
+    }
 
     return 0;
 
@@ -1,39 +1,41 @@
+#include <algorithm>
 #include <iostream>
+#include <thread>
 #include <vector>
-#include <future>
-#include <mutex>
+#include "bounded_executor.hpp"
+#include "sharded_buffer.hpp"
 
-// Shared resource
-std::vector<int> shared_data;
-std::mutex data_mutex;
+// Shared resource: one buffer per shard instead of one vector behind one mutex
+ShardedBuffer<int> shared_data;
 
 // Function to modify the shared resource
 void modify_shared_data(int id)
 {
-    std::lock_guard<std::mutex> lock(data_mutex); // Lock the mutex
-    shared_data.push_back(id);
-    std::cout << "Task " << id << " added data.\n";
+    shared_data.push(id); // Only contends with threads that share the shard
 }
 
 int main()
 {
     const int numTasks = 10;
-    std::vector<std::future<void>> futures;
 
-    // Launch tasks asynchronously
+    // At most one running task per core and 64 waiting ones; submit() blocks when the queue is full
+    BoundedExecutor executor(std::max(1u, std::thread::hardware_concurrency()), 64, Overflow::Block);
+
+    // Submit the tasks to the executor instead of starting a thread for each
     for (int i = 0; i < numTasks; ++i)
     {
-        futures.push_back(std::async(std::launch::async, modify_shared_data, i));
+        executor.submit([i] { modify_shared_data(i); });
     }
 
     // Wait for all tasks to complete
-    for (auto& f : futures) {
-        f.get();
-    }
+    executor.wait();
+
+    // Merge the shards once, then print the contents of the shared resource
+    std::vector<int> data = shared_data.merge();
+    std::sort(data.begin(), data.end());
 
-    // Print the contents of the shared resource
     std::cout << "Shared data: ";
-    for (int value : shared_data)
+    for (int value : data)
     {
         std::cout << value << " ";
     }
@@ -0,0 +1,37 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "bounded_executor.hpp"
+#include "future.hpp"
+
+// Function to be run asynchronously
+int compute(int x)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // Simulate a long computation
+    return x * x;
+}
+
+int main()
+{
+    BoundedExecutor compute_pool(2, 16);
+    BoundedExecutor io_pool(1, 16);
+
+    // Launch the function asynchronously and describe what to do with its result.
+    // No thread waits between the steps: each one starts when the previous one completes.
+    Future<void> done = async_on(compute_pool, compute, 5)
+        .then([](int square) { return compute(square); }) // runs on the compute thread that finished
+        .via(io_pool)                                    // the following steps run on io_pool
+        .then([](int value) { return "Result: " + std::to_string(value); })
+        .then([](const std::string& line) { std::cout << line << std::endl; });
+
+    // Do other work while the chain runs
+    std::cout << "Doing other work...\n";
+
+    // Only the end of the program waits
+    done.get();
+
+    compute_pool.wait();
+    io_pool.wait();
+    return 0;
+}
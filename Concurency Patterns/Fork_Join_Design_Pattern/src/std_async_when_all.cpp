@@ -0,0 +1,61 @@
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <vector>
+#include "bounded_executor.hpp"
+#include "when.hpp"
+
+// Function that may throw an exception; slow inputs give up when stop is requested
+int risky_compute(std::stop_token token, int x)
+{
+    if (x < 0) throw std::runtime_error("Negative input not allowed: " + std::to_string(x));
+
+    for (int step = 0; step < x; ++step)
+    {
+        if (token.stop_requested()) throw OperationCancelled();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Simulate a long computation
+    }
+    return x * x;
+}
+
+int main()
+{
+    BoundedExecutor executor(4, 64);
+
+    // Fan out: every result is awaited at once, failures are seen as soon as they happen
+    std::vector<int> inputs = {3, -1, 50, -2, 5};
+    std::stop_source cancel;
+    std::vector<Future<int>> results;
+    for (int x : inputs)
+    {
+        results.push_back(async_on(executor, cancel.get_token(), risky_compute, x));
+    }
+
+    try
+    {
+        // The first failure cancels the siblings that are still running
+        std::vector<int> values = when_all(cancel, std::move(results)).get();
+        std::cout << "All results: " << values.size() << std::endl;
+    }
+    catch (const AggregateError& e)
+    {
+        std::cerr << "Errors (" << e.errors().size() << "): " << e.what() << std::endl;
+    }
+
+    // First successful result wins, the slower tasks are cancelled
+    std::stop_source race;
+    std::vector<Future<int>> candidates;
+    for (int x : {-3, 40, 2})
+    {
+        candidates.push_back(async_on(executor, race.get_token(), risky_compute, x));
+    }
+
+    WhenAnyResult<int> first = when_any(race, std::move(candidates)).get();
+    std::cout << "First result: input #" << first.index << " = " << first.value << std::endl;
+
+    executor.wait();
+
+    return 0;
+}
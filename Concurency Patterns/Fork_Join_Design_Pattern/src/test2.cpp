@@ -1,39 +1,57 @@
+#include <cstdint>
 #include <iostream>
+#include <string>
 #include <vector>
-#include <future>
+#include "partitioner.hpp"
+#include "simd_reduce.hpp"
 
-// Function to compute the sum of elements in a range
-int parallel_sum(const std::vector<int>& arr, int start, int end)
+// Function to compute the sum of elements in a range, split as decided by the partitioner
+template <typename Partitioner>
+std::int64_t parallel_sum(ForkJoinPool& pool, const std::vector<int>& arr, int start, int end, Partitioner&& partitioner)
 {
-    // Base case: if the range is small, compute directly
-    if (end - start < 1000)
-    {
-        int sum = 0;
-        for (int i = start; i < end; ++i)
+    return parallel_reduce(pool, start, end, std::int64_t(0),
+        // Leaf: the range is small, compute directly with the vectorized kernel (64-bit accumulators)
+        [&arr](std::size_t first, std::size_t last)
         {
-            sum += arr[i];
-        }
-        return sum;
-    }
-
-    // Recursive case: split the range and compute in parallel
-    int mid = start + (end - start) / 2;
-    auto left_future = std::async(std::launch::async, parallel_sum, std::ref(arr), start, mid);
-    auto right_future = std::async(std::launch::async, parallel_sum, std::ref(arr), mid, end);
-
-    // Join: wait for both halves to complete and combine results
-    return left_future.get() + right_future.get();
+            return simd::sum(arr.data() + first, last - first);
+        },
+        // Join: combine the results of both halves
+        [](std::int64_t left, std::int64_t right) { return left + right; },
+        std::forward<Partitioner>(partitioner));
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Partitioner policy: static, simple or auto (default)
+    std::string policy = argc > 1 ? argv[1] : "auto";
+
+    // Fixed number of worker threads shared by every reduction
+    ForkJoinPool pool;
+
     // Create a large array of integers
     std::vector<int> arr(10000, 1); // Array of 10000 elements, all initialized to 1
 
     // Compute the sum using parallel computation
-    int total_sum = parallel_sum(arr, 0, arr.size());
+    std::int64_t total_sum = 0;
+    if (policy == "static")
+    {
+        total_sum = parallel_sum(pool, arr, 0, arr.size(), StaticPartitioner());
+    }
+    else if (policy == "simple")
+    {
+        total_sum = parallel_sum(pool, arr, 0, arr.size(), SimplePartitioner(1000));
+    }
+    else
+    {
+        AutoPartitioner partitioner;
+        total_sum = parallel_sum(pool, arr, 0, arr.size(), partitioner);
+
+        AutoPartitioner::Stats stats = partitioner.stats();
+        std::cout << "Leaves: " << stats.leaves << ", steals: " << stats.steals
+                  << ", learned grain: " << stats.grain << std::endl;
+    }
 
-    std::cout << "Total sum: " << total_sum << std::endl;
+    std::cout << "Total sum: " << total_sum << " (" << simd::isa_name(simd::active_isa()) << " leaf kernel)" << std::endl;
 
     return 0;
 }
@@ -0,0 +1,382 @@
+/*
+
+when_all / when_any
+
+Both combinators return a Future right away. They register a callback on each
+input future (Future::on_ready), so no thread waits, and each input is
+observed as soon as it completes, whatever its position.
+
+when_all(futures)           : Future<std::vector<T>> (Future<void> for void inputs)
+when_all(f1, f2, ...)       : Future<std::tuple<T1, T2, ...>>, void inputs give std::monostate
+when_any(futures)           : Future<WhenAnyResult<T>>, the first input that succeeds
+
+when_all waits until every input has completed. If any of them failed, its
+future fails with an AggregateError holding every exception, in input order.
+when_any fails with an AggregateError only when every input failed. An
+OperationCancelled is left out of the AggregateError when other inputs failed
+for real: it is the consequence of a failure, not one of its own. With no
+input, when_all is ready at once and when_any fails.
+
+Cancellation: given a std::stop_source as first argument, when_all requests stop
+on the first failure, and when_any requests stop as soon as it has a winner.
+Tasks started with async_on(executor, source.get_token(), f) then do not start,
+or see token.stop_requested() and can return early.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "future.hpp"
+
+// Every exception thrown by the tasks of a when_all (or by all the tasks of a when_any)
+class AggregateError : public std::exception
+{
+public:
+    AggregateError(std::vector<std::exception_ptr> errors_, std::size_t total) : list(std::move(errors_))
+    {
+        message = std::to_string(list.size()) + " of " + std::to_string(total) + " tasks failed";
+        for (const std::exception_ptr& e : list)
+        {
+            try
+            {
+                std::rethrow_exception(e);
+            }
+            catch (const std::exception& ex)
+            {
+                message += std::string("; ") + ex.what();
+            }
+            catch (...)
+            {
+                message += "; unknown exception";
+            }
+        }
+    }
+
+    const std::vector<std::exception_ptr>& errors() const { return list; }
+    const char* what() const noexcept override { return message.c_str(); }
+
+private:
+    std::vector<std::exception_ptr> list;
+    std::string message;
+};
+
+template <typename T>
+struct WhenAnyResult
+{
+    std::size_t index;
+    detail::Stored<T> value;
+};
+
+namespace detail
+{
+
+// Reads a completed future without blocking: returns an error instead of throwing it
+template <typename T>
+std::exception_ptr take_into(Future<T>& future, std::optional<Stored<T>>& slot)
+{
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            future.get();
+            slot.emplace();
+        }
+        else
+        {
+            slot.emplace(future.get());
+        }
+        return nullptr;
+    }
+    catch (...)
+    {
+        return std::current_exception();
+    }
+}
+
+inline bool is_cancellation(const std::exception_ptr& e)
+{
+    try
+    {
+        std::rethrow_exception(e);
+    }
+    catch (const OperationCancelled&)
+    {
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+// Exceptions of a when_all, kept by input index
+struct ErrorSlots
+{
+    explicit ErrorSlots(std::size_t n) : slots(n) {}
+
+    void set(std::size_t i, std::exception_ptr e)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        slots[i] = std::move(e);
+        any = true;
+    }
+
+    // Non-null when at least one input failed. Cancellations only count when nothing else failed
+    std::exception_ptr aggregate()
+    {
+        if (!any) return nullptr;
+
+        std::vector<std::exception_ptr> failures;
+        std::vector<std::exception_ptr> cancellations;
+        for (std::exception_ptr& e : slots)
+        {
+            if (e) (is_cancellation(e) ? cancellations : failures).push_back(std::move(e));
+        }
+        if (failures.empty()) failures = std::move(cancellations);
+        return std::make_exception_ptr(AggregateError(std::move(failures), slots.size()));
+    }
+
+    std::mutex mtx;
+    std::vector<std::exception_ptr> slots;
+    bool any = false;
+};
+
+template <typename T>
+struct WhenAllState
+{
+    using Result = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+    WhenAllState(std::vector<Future<T>> inputs_, std::optional<std::stop_source> cancel_)
+        : inputs(std::move(inputs_)), values(inputs.size()), errors(inputs.size()), remaining(inputs.size()),
+          cancel(std::move(cancel_))
+    {
+    }
+
+    void arrive(std::size_t i)
+    {
+        if (std::exception_ptr e = take_into(inputs[i], values[i]))
+        {
+            errors.set(i, std::move(e));
+            if (cancel) cancel->request_stop();
+        }
+
+        // acq_rel: the last input to arrive sees the values and errors of the others
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            finish();
+        }
+    }
+
+    void finish()
+    {
+        if (std::exception_ptr e = errors.aggregate())
+        {
+            promise.set_exception(std::move(e));
+        }
+        else if constexpr (std::is_void_v<T>)
+        {
+            promise.set_value();
+        }
+        else
+        {
+            std::vector<T> result;
+            result.reserve(values.size());
+            for (std::optional<T>& value : values)
+            {
+                result.push_back(std::move(*value));
+            }
+            promise.set_value(std::move(result));
+        }
+    }
+
+    std::vector<Future<T>> inputs;
+    std::vector<std::optional<Stored<T>>> values;
+    ErrorSlots errors;
+    std::atomic<std::size_t> remaining;
+    std::optional<std::stop_source> cancel;
+    Promise<Result> promise;
+};
+
+template <typename... Ts>
+struct WhenAllTupleState
+{
+    using Result = std::tuple<Stored<Ts>...>;
+
+    WhenAllTupleState(std::tuple<Future<Ts>...> inputs_, std::optional<std::stop_source> cancel_)
+        : inputs(std::move(inputs_)), errors(sizeof...(Ts)), remaining(sizeof...(Ts)), cancel(std::move(cancel_))
+    {
+    }
+
+    template <std::size_t I>
+    void arrive()
+    {
+        if (std::exception_ptr e = take_into(std::get<I>(inputs), std::get<I>(values)))
+        {
+            errors.set(I, std::move(e));
+            if (cancel) cancel->request_stop();
+        }
+
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            if (std::exception_ptr e = errors.aggregate())
+            {
+                promise.set_exception(std::move(e));
+            }
+            else
+            {
+                promise.set_value(std::apply([](auto&... value) { return Result(std::move(*value)...); }, values));
+            }
+        }
+    }
+
+    std::tuple<Future<Ts>...> inputs;
+    std::tuple<std::optional<Stored<Ts>>...> values;
+    ErrorSlots errors;
+    std::atomic<std::size_t> remaining;
+    std::optional<std::stop_source> cancel;
+    Promise<Result> promise;
+};
+
+template <typename T>
+struct WhenAnyState
+{
+    WhenAnyState(std::vector<Future<T>> inputs_, std::optional<std::stop_source> cancel_)
+        : inputs(std::move(inputs_)), errors(inputs.size()), remaining(inputs.size()), cancel(std::move(cancel_))
+    {
+    }
+
+    void arrive(std::size_t i)
+    {
+        std::optional<Stored<T>> value;
+        if (std::exception_ptr e = take_into(inputs[i], value))
+        {
+            errors.set(i, std::move(e));
+        }
+        else if (!won.exchange(true, std::memory_order_acq_rel))
+        {
+            if (cancel) cancel->request_stop();
+            promise.set_value(WhenAnyResult<T>{i, std::move(*value)});
+        }
+
+        // Every input failed: nobody won
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && !won.load(std::memory_order_acquire))
+        {
+            promise.set_exception(errors.aggregate());
+        }
+    }
+
+    std::vector<Future<T>> inputs;
+    ErrorSlots errors;
+    std::atomic<std::size_t> remaining;
+    std::atomic<bool> won{false};
+    std::optional<std::stop_source> cancel;
+    Promise<WhenAnyResult<T>> promise;
+};
+
+template <typename T>
+auto when_all(std::vector<Future<T>> futures, std::optional<std::stop_source> cancel)
+{
+    using State = WhenAllState<T>;
+    auto state = std::make_shared<State>(std::move(futures), std::move(cancel));
+    Future<typename State::Result> result = state->promise.get_future();
+
+    if (state->inputs.empty())
+    {
+        state->finish();
+        return result;
+    }
+
+    // Each callback keeps the state alive until it has run
+    for (std::size_t i = 0; i < state->inputs.size(); ++i)
+    {
+        state->inputs[i].on_ready([state, i] { state->arrive(i); });
+    }
+    return result;
+}
+
+template <typename... Ts>
+Future<std::tuple<Stored<Ts>...>> when_all(std::optional<std::stop_source> cancel, Future<Ts>... futures)
+{
+    auto state = std::make_shared<WhenAllTupleState<Ts...>>(std::make_tuple(std::move(futures)...), std::move(cancel));
+    auto result = state->promise.get_future();
+
+    if constexpr (sizeof...(Ts) == 0)
+    {
+        state->promise.set_value(std::tuple<>());
+        return result;
+    }
+
+    [&]<std::size_t... I>(std::index_sequence<I...>)
+    {
+        (std::get<I>(state->inputs).on_ready([state] { state->template arrive<I>(); }), ...);
+    }(std::index_sequence_for<Ts...>());
+    return result;
+}
+
+template <typename T>
+Future<WhenAnyResult<T>> when_any(std::vector<Future<T>> futures, std::optional<std::stop_source> cancel)
+{
+    auto state = std::make_shared<WhenAnyState<T>>(std::move(futures), std::move(cancel));
+    Future<WhenAnyResult<T>> result = state->promise.get_future();
+
+    if (state->inputs.empty())
+    {
+        state->promise.set_exception(std::make_exception_ptr(AggregateError({}, 0)));
+        return result;
+    }
+
+    for (std::size_t i = 0; i < state->inputs.size(); ++i)
+    {
+        state->inputs[i].on_ready([state, i] { state->arrive(i); });
+    }
+    return result;
+}
+
+} // namespace detail
+
+template <typename T>
+auto when_all(std::vector<Future<T>> futures)
+{
+    return detail::when_all(std::move(futures), std::nullopt);
+}
+
+template <typename T>
+auto when_all(std::stop_source cancel, std::vector<Future<T>> futures)
+{
+    return detail::when_all(std::move(futures), std::move(cancel));
+}
+
+template <typename... Ts>
+auto when_all(Future<Ts>... futures)
+{
+    return detail::when_all(std::nullopt, std::move(futures)...);
+}
+
+template <typename... Ts>
+auto when_all(std::stop_source cancel, Future<Ts>... futures)
+{
+    return detail::when_all(std::optional<std::stop_source>(std::move(cancel)), std::move(futures)...);
+}
+
+template <typename T>
+Future<WhenAnyResult<T>> when_any(std::vector<Future<T>> futures)
+{
+    return detail::when_any(std::move(futures), std::nullopt);
+}
+
+template <typename T>
+Future<WhenAnyResult<T>> when_any(std::stop_source cancel, std::vector<Future<T>> futures)
+{
+    return detail::when_any(std::move(futures), std::move(cancel));
+}
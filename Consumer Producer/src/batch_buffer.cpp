@@ -0,0 +1,102 @@
+/*
+
+Batched producers and consumers
+
+The two producers and two consumers of ConsumerProducerUnboundedBuffer.md on a
+BatchBuffer (batch_buffer.hpp):
+
+- Each producer hands over its items in batches with push_bulk, one lock
+  acquisition per batch.
+- Each consumer drains up to MAX_BATCH items per pop_bulk. With LINGER it waits
+  a little for the high-water mark before taking what is there.
+- Consumers only get a wake-up when the buffer goes from empty to non-empty or
+  crosses the high-water mark, not on every item.
+- main() closes the buffer once the producers are done, so the consumers end
+  instead of being detached.
+
+*/
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "batch_buffer.hpp"
+
+using namespace std::chrono_literals;
+
+const int ITEMS = 40;
+const int PRODUCER_BATCH = 8;
+const std::size_t MAX_BATCH = 16;
+const std::size_t HIGH_WATER = 8;
+const auto LINGER = 2ms;
+
+BatchBuffer<int> buffer(0, HIGH_WATER); // Unbounded
+
+void producer(int id)
+{
+    std::vector<int> batch;
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        batch.push_back(id * 100 + i);
+        if (batch.size() == PRODUCER_BATCH)
+        {
+            buffer.push_bulk(batch);
+
+            std::ostringstream line;
+            line << "Producer " << id << " produced " << batch.front() << ".." << batch.back() << "\n";
+            std::cout << line.str();
+            batch.clear();
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    buffer.push_bulk(batch);
+}
+
+void consumer(int id)
+{
+    int items[MAX_BATCH];
+    for (;;)
+    {
+        std::size_t n = buffer.pop_bulk(items, MAX_BATCH, 100ms, LINGER);
+        if (n == 0)
+        {
+            if (buffer.is_closed()) break; // Closed and drained
+            continue;                      // Timed out
+        }
+
+        std::ostringstream line;
+        line << "Consumer " << id << " consumed";
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            line << " " << items[k];
+        }
+        line << "\n";
+        std::cout << line.str();
+    }
+}
+
+int main()
+{
+    std::thread producers[2];
+    std::thread consumers[2];
+
+    for (int i = 0; i < 2; ++i)
+    {
+        producers[i] = std::thread(producer, i);
+        consumers[i] = std::thread(consumer, i);
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        producers[i].join();
+    }
+
+    buffer.close();
+    for (int i = 0; i < 2; ++i)
+    {
+        consumers[i].join();
+    }
+
+    return 0;
+}
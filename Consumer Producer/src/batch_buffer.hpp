@@ -0,0 +1,184 @@
+/*
+
+Producer/consumer buffer with batched operations and coalesced wake-ups
+
+The buffers of ConsumerProducerBoundedBuffer.md and
+ConsumerProducerUnboundedBuffer.md take the mutex and call notify_all() once
+per int. BatchBuffer<T> keeps the mutex and the condition variables, but pays
+for them once per batch:
+
+push_bulk(items)           : appends a whole span under one lock acquisition.
+                             A bounded buffer takes as much as fits, waits for
+                             room and continues; an unbounded one (capacity 0)
+                             never waits.
+pop_bulk(out, max, timeout): waits up to `timeout` for the first item, then
+                             moves up to `max` items out under the same lock.
+pop_bulk(..., linger)      : once an item is there, waits up to `linger` more
+                             for the buffer to reach the high-water mark, so
+                             that a slow trickle is drained in batches. If
+                             other consumers empty the buffer meanwhile, it
+                             goes back to waiting until `timeout` runs out.
+close()                    : wakes everybody; pop_bulk returns 0 once the
+                             buffer is closed and drained.
+
+Wake-ups are coalesced:
+
+- Sleeping consumers are woken only when the buffer goes from empty to
+  non-empty, and then only one of them. A consumer that leaves items behind
+  wakes the next sleeper.
+- Lingering consumers are woken when a push crosses the high-water mark.
+- Producers waiting for room are woken when a pop takes the buffer off full.
+- Nobody is notified when the counters say nobody waits.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <ratio>
+#include <span>
+#include <utility>
+
+template <typename T>
+class BatchBuffer
+{
+public:
+    // capacity 0 means unbounded; the high-water mark is at most the capacity
+    explicit BatchBuffer(std::size_t capacity_ = 0, std::size_t high_water_ = 64)
+        : capacity(capacity_),
+          high_water(std::clamp<std::size_t>(high_water_, 1, capacity_ ? capacity_ : high_water_ + 1))
+    {
+    }
+
+    BatchBuffer(const BatchBuffer&) = delete;
+    BatchBuffer& operator=(const BatchBuffer&) = delete;
+
+    // Returns how many items were pushed; fewer than items.size() only if the buffer was closed
+    std::size_t push_bulk(std::span<const T> items)
+    {
+        std::size_t sent = 0;
+        std::unique_lock<std::mutex> lock(mtx);
+        while (sent < items.size() && !closed)
+        {
+            if (capacity && buffer.size() >= capacity)
+            {
+                ++waiting_producers;
+                cv_producer.wait(lock, [this] { return closed || buffer.size() < capacity; });
+                --waiting_producers;
+                continue;
+            }
+
+            std::size_t room = capacity ? capacity - buffer.size() : items.size() - sent;
+            std::size_t n = std::min(room, items.size() - sent);
+            std::size_t before = buffer.size();
+            buffer.insert(buffer.end(), items.begin() + sent, items.begin() + sent + n);
+            sent += n;
+            wake_consumers(before);
+        }
+        return sent;
+    }
+
+    bool push(T value)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (capacity && buffer.size() >= capacity)
+        {
+            ++waiting_producers;
+            cv_producer.wait(lock, [this] { return closed || buffer.size() < capacity; });
+            --waiting_producers;
+        }
+        if (closed) return false;
+
+        std::size_t before = buffer.size();
+        buffer.push_back(std::move(value));
+        wake_consumers(before);
+        return true;
+    }
+
+    // Moves up to `max` items to `out`; returns how many, 0 on timeout or when closed and drained
+    template <typename OutputIt, typename Rep1, typename Period1, typename Rep2 = long, typename Period2 = std::ratio<1>>
+    std::size_t pop_bulk(OutputIt out, std::size_t max,
+                         std::chrono::duration<Rep1, Period1> timeout,
+                         std::chrono::duration<Rep2, Period2> linger = std::chrono::duration<Rep2, Period2>::zero())
+    {
+        if (max == 0) return 0;
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(mtx);
+        for (;;)
+        {
+            if (buffer.empty())
+            {
+                ++sleeping_consumers;
+                cv_consumer.wait_until(lock, deadline, [this] { return closed || !buffer.empty(); });
+                --sleeping_consumers;
+                if (buffer.empty()) return 0;
+            }
+
+            if (linger > linger.zero() && buffer.size() < high_water && !closed)
+            {
+                ++lingering_consumers;
+                cv_linger.wait_for(lock, linger, [this] { return closed || buffer.size() >= high_water; });
+                --lingering_consumers;
+            }
+
+            if (!buffer.empty()) break;
+            // Other consumers took the items while this one lingered: wait again until the deadline
+        }
+
+        std::size_t before = buffer.size();
+        std::size_t n = std::min(max, before);
+        std::move(buffer.begin(), buffer.begin() + n, out);
+        buffer.erase(buffer.begin(), buffer.begin() + n);
+
+        if (!buffer.empty() && sleeping_consumers) cv_consumer.notify_one();
+        if (capacity && before >= capacity && waiting_producers) cv_producer.notify_all();
+        return n;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        cv_producer.notify_all();
+        cv_consumer.notify_all();
+        cv_linger.notify_all();
+    }
+
+    bool is_closed() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return closed;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return buffer.size();
+    }
+
+private:
+    // Called with the lock held after the buffer grew from `before` items
+    void wake_consumers(std::size_t before)
+    {
+        if (before == 0 && sleeping_consumers) cv_consumer.notify_one();
+        if (lingering_consumers && before < high_water && buffer.size() >= high_water) cv_linger.notify_all();
+    }
+
+    const std::size_t capacity;
+    const std::size_t high_water;
+
+    mutable std::mutex mtx;
+    std::condition_variable cv_producer, cv_consumer, cv_linger;
+    std::deque<T> buffer;
+    std::size_t waiting_producers = 0;
+    std::size_t sleeping_consumers = 0;
+    std::size_t lingering_consumers = 0;
+    bool closed = false;
+};
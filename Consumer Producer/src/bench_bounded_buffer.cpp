@@ -0,0 +1,257 @@
+/*
+
+Benchmark of bounded buffers
+
+CondvarBuffer     : std::queue + mutex + cv_producer / cv_consumer with
+                    notify_all() on every item, as in ConsumerProducerBoundedBuffer.md.
+SpscRing          : spsc_ring.hpp, one item at a time (push / pop).
+SpscRingBatch     : spsc_ring.hpp, try_push_n / try_pop_n with batches of 64.
+BlockingMpmcQueue : mpmc_queue.hpp, push / pop.
+BatchBuffer       : batch_buffer.hpp, push_bulk / pop_bulk.
+
+BM_one_by_one and BM_spsc_batch move `items` integers from one producer thread
+to one consumer thread; the argument is the buffer capacity. BM_many_to_many
+runs the same number of producers and consumers (the argument) through a
+buffer of `many_capacity` slots. BM_batch_buffer moves `items` integers from
+one producer to one consumer through a BatchBuffer of `many_capacity` slots;
+the argument is the batch size. All report items/s.
+
+*/
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <span>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "batch_buffer.hpp"
+#include "bench_support.hpp"
+#include "mpmc_queue.hpp"
+#include "spsc_ring.hpp"
+
+namespace
+{
+
+const std::int64_t items = 1 << 20;
+const std::size_t batch = 64;
+const std::int64_t many_items = 1 << 18;
+const std::size_t many_capacity = 1024;
+
+class CondvarBuffer
+{
+public:
+    explicit CondvarBuffer(std::size_t capacity_) : capacity(capacity_) {}
+
+    void push(std::int64_t value)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv_producer.wait(lock, [this] { return buffer.size() < capacity; });
+        buffer.push(value);
+        cv_consumer.notify_all();
+    }
+
+    std::int64_t pop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv_consumer.wait(lock, [this] { return !buffer.empty(); });
+        std::int64_t value = buffer.front();
+        buffer.pop();
+        cv_producer.notify_all();
+        return value;
+    }
+
+private:
+    std::size_t capacity;
+    std::queue<std::int64_t> buffer;
+    std::mutex mtx;
+    std::condition_variable cv_producer, cv_consumer;
+};
+
+template <typename Buffer>
+void BM_one_by_one(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        Buffer buffer(static_cast<std::size_t>(state.range(0)));
+
+        std::thread producerThread([&buffer]
+        {
+            for (std::int64_t i = 0; i < items; ++i)
+            {
+                buffer.push(i);
+            }
+        });
+
+        std::int64_t sum = 0;
+        for (std::int64_t i = 0; i < items; ++i)
+        {
+            sum += buffer.pop();
+        }
+        producerThread.join();
+
+        if (sum != items * (items - 1) / 2)
+        {
+            state.SkipWithError("lost items");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * items);
+}
+
+void BM_spsc_batch(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        SpscRing<std::int64_t> buffer(static_cast<std::size_t>(state.range(0)));
+
+        std::thread producerThread([&buffer]
+        {
+            std::vector<std::int64_t> values(batch);
+            for (std::int64_t next = 0; next < items; )
+            {
+                std::size_t wanted = static_cast<std::size_t>(std::min<std::int64_t>(batch, items - next));
+                for (std::size_t k = 0; k < wanted; ++k)
+                {
+                    values[k] = next + static_cast<std::int64_t>(k);
+                }
+
+                std::size_t sent = 0;
+                for (int spins = 0; sent < wanted; )
+                {
+                    std::size_t n = buffer.try_push_n(values.begin() + sent, wanted - sent);
+                    sent += n;
+                    if (n == 0 && ++spins > 64) std::this_thread::yield();
+                }
+                next += static_cast<std::int64_t>(wanted);
+            }
+        });
+
+        std::int64_t sum = 0;
+        std::vector<std::int64_t> values(batch);
+        for (std::int64_t received = 0, spins = 0; received < items; )
+        {
+            std::size_t n = buffer.try_pop_n(values.begin(), batch);
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                sum += values[k];
+            }
+            received += static_cast<std::int64_t>(n);
+            if (n == 0 && ++spins > 64) std::this_thread::yield();
+        }
+        producerThread.join();
+
+        if (sum != items * (items - 1) / 2)
+        {
+            state.SkipWithError("lost items");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * items);
+}
+
+template <typename Buffer>
+void BM_many_to_many(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+    const std::int64_t per_thread = many_items / threads;
+    const std::int64_t total = per_thread * threads;
+
+    for (auto _ : state)
+    {
+        Buffer buffer(many_capacity);
+        if (!run_threads_per_side(threads, per_thread,
+                                  [&buffer](int, std::int64_t, std::int64_t value) { buffer.push(value); },
+                                  [&buffer] { return buffer.pop(); }))
+        {
+            state.SkipWithError("lost items");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+void BM_batch_buffer(benchmark::State& state)
+{
+    const std::size_t batch_size = static_cast<std::size_t>(state.range(0));
+
+    for (auto _ : state)
+    {
+        BatchBuffer<std::int64_t> buffer(many_capacity, batch_size);
+
+        std::thread producerThread([&buffer, batch_size]
+        {
+            std::vector<std::int64_t> values(batch_size);
+            for (std::int64_t next = 0; next < items; )
+            {
+                std::size_t n = static_cast<std::size_t>(std::min<std::int64_t>(static_cast<std::int64_t>(batch_size), items - next));
+                for (std::size_t k = 0; k < n; ++k)
+                {
+                    values[k] = next + static_cast<std::int64_t>(k);
+                }
+                buffer.push_bulk(std::span<const std::int64_t>(values.data(), n));
+                next += static_cast<std::int64_t>(n);
+            }
+        });
+
+        std::int64_t sum = 0;
+        std::vector<std::int64_t> values(batch_size);
+        for (std::int64_t received = 0; received < items; )
+        {
+            std::size_t n = buffer.pop_bulk(values.begin(), batch_size, std::chrono::seconds(1));
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                sum += values[k];
+            }
+            received += static_cast<std::int64_t>(n);
+        }
+        producerThread.join();
+
+        if (sum != items * (items - 1) / 2)
+        {
+            state.SkipWithError("lost items");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * items);
+}
+
+void capacities(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("capacity");
+    for (int capacity : {16, 1024, 65536})
+    {
+        b->Arg(capacity);
+    }
+}
+
+void batch_sizes(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("batch");
+    for (int batch_size : {1, 16, 256})
+    {
+        b->Arg(batch_size);
+    }
+}
+
+void threads_per_side(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("threads");
+    for (int threads : {2, 4, 8, 16, 32})
+    {
+        b->Arg(threads);
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_one_by_one, CondvarBuffer)->Apply(capacities)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_one_by_one, SpscRing<std::int64_t>)->Apply(capacities)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_spsc_batch)->Apply(capacities)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_batch_buffer)->Apply(batch_sizes)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_many_to_many, CondvarBuffer)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_many_to_many, BlockingMpmcQueue<std::int64_t>)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
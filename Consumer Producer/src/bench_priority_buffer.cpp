@@ -0,0 +1,102 @@
+/*
+
+Benchmark of priority producer/consumer queues
+
+HeapQueue      : std::priority_queue of (priority, item) under one mutex with a
+                 condition variable, as in the Leader/Followers example.
+PriorityBuffer : priority_buffer.hpp with 8 levels.
+
+The argument is the number of producers, with as many consumers. Producers push
+`items` integers with priorities cycling through the 8 levels; the buffer holds
+up to `items` at a time, so the heap has real depth. Reports items/s.
+
+*/
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <benchmark/benchmark.h>
+#include "bench_support.hpp"
+#include "priority_buffer.hpp"
+
+namespace
+{
+
+const std::int64_t items = 1 << 18;
+const std::size_t levels = 8;
+
+class HeapQueue
+{
+public:
+    void push(std::size_t priority, std::int64_t value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            heap.emplace(priority, value);
+        }
+        cv.notify_one();
+    }
+
+    std::int64_t pop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return !heap.empty(); });
+        std::int64_t value = heap.top().second;
+        heap.pop();
+        return value;
+    }
+
+private:
+    std::priority_queue<std::pair<std::size_t, std::int64_t>> heap;
+    std::mutex mtx;
+    std::condition_variable cv;
+};
+
+class LevelQueue
+{
+public:
+    void push(std::size_t priority, std::int64_t value) { buffer.push(priority, value); }
+    std::int64_t pop() { return buffer.pop()->second; }
+
+private:
+    PriorityBuffer<std::int64_t, levels> buffer;
+};
+
+template <typename Queue>
+void BM_priority(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+    const std::int64_t per_thread = items / threads;
+    const std::int64_t total = per_thread * threads;
+
+    for (auto _ : state)
+    {
+        Queue queue;
+        if (!run_threads_per_side(threads, per_thread,
+                                  [&queue](int, std::int64_t i, std::int64_t value) { queue.push(static_cast<std::size_t>(i) % levels, value); },
+                                  [&queue] { return queue.pop(); }))
+        {
+            state.SkipWithError("lost items");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+void threads_per_side(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("threads");
+    for (int threads : {1, 2, 4, 8})
+    {
+        b->Arg(threads);
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_priority, HeapQueue)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_priority, LevelQueue)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
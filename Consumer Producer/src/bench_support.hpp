@@ -0,0 +1,52 @@
+/*
+
+Shared body of the producer/consumer benchmarks
+
+run_threads_per_side(threads, per_thread, push, pop) starts `threads` producers
+and as many consumers. Producer t calls push(t, i, value) for i < per_thread,
+with value = t * per_thread + i; each consumer calls pop() per_thread times.
+Every value 0 .. n-1 is pushed exactly once, so the consumers must see them sum
+to n * (n - 1) / 2. Returns false if they do not (items lost or duplicated).
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+template <typename Push, typename Pop>
+bool run_threads_per_side(int threads, std::int64_t per_thread, Push push, Pop pop)
+{
+    std::atomic<std::int64_t> sum{0};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&push, t, per_thread]
+        {
+            for (std::int64_t i = 0; i < per_thread; ++i)
+            {
+                push(t, i, t * per_thread + i);
+            }
+        });
+        workers.emplace_back([&pop, &sum, per_thread]
+        {
+            std::int64_t local = 0;
+            for (std::int64_t i = 0; i < per_thread; ++i)
+            {
+                local += pop();
+            }
+            sum.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    const std::int64_t total = per_thread * threads;
+    return sum.load() == total * (total - 1) / 2;
+}
@@ -0,0 +1,116 @@
+/*
+
+Benchmark of unbounded buffers under bursts
+
+MutexQueue     : std::queue + mutex + condition variable, as in
+                 ConsumerProducerUnboundedBuffer.md (notify_one instead of
+                 notify_all).
+SegmentedQueue : segmented_queue.hpp.
+
+The argument is the number of producers, with as many consumers. Producers push
+`items` integers as fast as they can, so the buffer grows while the consumers
+catch up; each consumer stops after its share. The same buffer is reused by
+every iteration, as a long-running service would. Reports items/s and the slowest single push seen.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "bench_support.hpp"
+#include "segmented_queue.hpp"
+
+namespace
+{
+
+const std::int64_t items = 1 << 18;
+
+class MutexQueue
+{
+public:
+    void push(std::int64_t value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            buffer.push(value);
+        }
+        cv.notify_one();
+    }
+
+    std::optional<std::int64_t> pop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return closed || !buffer.empty(); });
+        if (buffer.empty()) return std::nullopt;
+        std::int64_t value = buffer.front();
+        buffer.pop();
+        return value;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        cv.notify_all();
+    }
+
+private:
+    std::queue<std::int64_t> buffer;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool closed = false;
+};
+
+template <typename Buffer>
+void BM_bursts(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+    const std::int64_t per_thread = items / threads;
+    const std::int64_t total = per_thread * threads;
+
+    Buffer buffer;
+    std::chrono::nanoseconds slowest_push{0};
+
+    for (auto _ : state)
+    {
+        std::vector<std::chrono::nanoseconds> slowest(threads, std::chrono::nanoseconds{0});
+        auto timed_push = [&buffer, &slowest](int t, std::int64_t, std::int64_t value)
+        {
+            auto start = std::chrono::steady_clock::now();
+            buffer.push(value);
+            slowest[t] = std::max(slowest[t], std::chrono::steady_clock::now() - start);
+        };
+        if (!run_threads_per_side(threads, per_thread, timed_push, [&buffer] { return *buffer.pop(); }))
+        {
+            state.SkipWithError("lost items");
+            return;
+        }
+        slowest_push = std::max(slowest_push, *std::max_element(slowest.begin(), slowest.end()));
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+    state.counters["max_push_us"] = std::chrono::duration<double, std::micro>(slowest_push).count();
+}
+
+void threads_per_side(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("threads");
+    for (int threads : {1, 2, 4, 8})
+    {
+        b->Arg(threads);
+    }
+}
+
+using Segmented = SegmentedQueue<std::int64_t>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_bursts, MutexQueue)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_bursts, Segmented)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
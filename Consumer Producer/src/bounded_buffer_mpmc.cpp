@@ -0,0 +1,67 @@
+/*
+
+Bounded buffer with several producers and several consumers
+
+The two producers and two consumers of ConsumerProducerBoundedBuffer.md, on a
+BlockingMpmcQueue (mpmc_queue.hpp) instead of std::queue + mutex + two
+condition variables:
+
+- Producers and consumers claim slots with one CAS each; there is no lock.
+- A thread only sleeps when the queue is really full or empty, and a push or
+  pop wakes at most one sleeper instead of every waiting thread.
+
+BUFFER_SIZE is rounded up to a power of two (16).
+
+*/
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "mpmc_queue.hpp"
+
+const int BUFFER_SIZE = 10;
+
+BlockingMpmcQueue<int> buffer(BUFFER_SIZE);
+
+void producer(int id)
+{
+    for (int i = 0; i < 20; ++i)
+    {
+        buffer.push(i);
+
+        std::ostringstream line;
+        line << "Producer " << id << " produced " << i << "\n";
+        std::cout << line.str();
+    }
+}
+
+void consumer(int id)
+{
+    for (int i = 0; i < 20; ++i)
+    {
+        int item = buffer.pop();
+
+        std::ostringstream line;
+        line << "Consumer " << id << " consumed " << item << "\n";
+        std::cout << line.str();
+    }
+}
+
+int main()
+{
+    std::thread producers[2], consumers[2];
+
+    for (int i = 0; i < 2; ++i)
+    {
+        producers[i] = std::thread(producer, i);
+        consumers[i] = std::thread(consumer, i);
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        producers[i].join();
+        consumers[i].join();
+    }
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+
+Bounded buffer with one producer and one consumer
+
+The same producer/consumer pair as ConsumerProducerBoundedBuffer.md, on an
+SpscRing (spsc_ring.hpp) instead of std::queue + mutex + two condition
+variables:
+
+- push() waits while the ring is full, pop() waits while it is empty; neither
+  takes a lock or sends a notification.
+- The second half moves the items in batches with try_push_n / try_pop_n: one
+  index update per batch instead of one per item.
+
+BUFFER_SIZE is rounded up to a power of two (16).
+
+*/
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "spsc_ring.hpp"
+
+const int BUFFER_SIZE = 10;
+const int ITEMS = 20;
+const int BATCH = 4;
+
+SpscRing<int> buffer(BUFFER_SIZE);
+
+void producer()
+{
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        buffer.push(i);
+
+        std::ostringstream line;
+        line << "Producer produced " << i << "\n";
+        std::cout << line.str();
+    }
+
+    // Batches: as many items as fit, the rest on the next round
+    std::vector<int> items;
+    for (int i = ITEMS; i < 2 * ITEMS; ++i)
+    {
+        items.push_back(i);
+    }
+    for (std::size_t sent = 0; sent < items.size(); )
+    {
+        std::size_t n = buffer.try_push_n(items.begin() + sent, std::min<std::size_t>(BATCH, items.size() - sent));
+        if (n == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::ostringstream line;
+        line << "Producer produced a batch of " << n << "\n";
+        std::cout << line.str();
+        sent += n;
+    }
+}
+
+void consumer()
+{
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        int item = buffer.pop();
+
+        std::ostringstream line;
+        line << "Consumer consumed " << item << "\n";
+        std::cout << line.str();
+    }
+
+    int batch[BATCH];
+    for (int received = 0; received < ITEMS; )
+    {
+        std::size_t n = buffer.try_pop_n(batch, BATCH);
+        if (n == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::ostringstream line;
+        line << "Consumer consumed";
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            line << " " << batch[k];
+        }
+        line << "\n";
+        std::cout << line.str();
+        received += static_cast<int>(n);
+    }
+}
+
+int main()
+{
+    std::thread producerThread(producer);
+    std::thread consumerThread(consumer);
+
+    producerThread.join();
+    consumerThread.join();
+
+    return 0;
+}
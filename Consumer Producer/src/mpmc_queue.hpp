@@ -0,0 +1,246 @@
+/*
+
+Bounded multi-producer / multi-consumer array queue (Vyukov)
+
+The bounded buffer of ConsumerProducerBoundedBuffer.md runs every producer and
+every consumer through one mutex, and each push wakes every waiting thread with
+notify_all(). MpmcQueue<T> has no lock:
+
+- The slots form a ring of power-of-two size. Each slot carries a sequence
+  number that says whose turn it is: a slot at position p is free for the
+  producer of position p when its sequence is p, and holds an item for the
+  consumer of position p when its sequence is p + 1.
+- A producer claims a position with one CAS on `enqueue_pos`, writes the item
+  and hands the slot over by storing p + 1. A consumer claims with one CAS on
+  `dequeue_pos`, moves the item out and frees the slot for the next lap by
+  storing p + capacity.
+- Producers and consumers only meet on the slot they exchange; the two counters
+  live on separate cache lines.
+
+try_push fails only when the queue is full, try_pop only when it is empty.
+
+BlockingMpmcQueue<T> adds push() / pop() that wait. A thread that finds the
+queue full (or empty) retries for a short while, then sleeps on an EventCount.
+The other side only makes a wake-up call when somebody actually sleeps, and
+then it wakes one thread instead of all of them.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include "cpu_relax.hpp"
+#include "event_count.hpp"
+
+template <typename T>
+class MpmcQueue
+{
+public:
+    // The capacity is rounded up to a power of two, at least 2
+    explicit MpmcQueue(std::size_t capacity_)
+        : mask(round_up(capacity_) - 1),
+          cells(std::allocator<Cell>().allocate(mask + 1))
+    {
+        for (std::size_t i = 0; i <= mask; ++i)
+        {
+            std::construct_at(&cells[i].sequence, i);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    ~MpmcQueue()
+    {
+        for (std::size_t i = dequeue_pos.load(std::memory_order_relaxed); i != enqueue_pos.load(std::memory_order_relaxed); ++i)
+        {
+            std::destroy_at(cells[i & mask].item());
+        }
+        std::allocator<Cell>().deallocate(cells, mask + 1);
+    }
+
+    template <typename U>
+    bool try_push(U&& value)
+    {
+        std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+            if (diff == 0)
+            {
+                // The slot is free for this lap; on failure `pos` holds the new position
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                return false; // The consumer of the previous lap has not freed it yet: full
+            }
+            else
+            {
+                pos = enqueue_pos.load(std::memory_order_relaxed); // Another producer took it
+            }
+        }
+
+        std::construct_at(cell->item(), std::forward<U>(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> try_pop()
+    {
+        std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+
+            if (diff == 0)
+            {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                return std::nullopt; // Not written yet: empty
+            }
+            else
+            {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        std::optional<T> value(std::move(*cell->item()));
+        std::destroy_at(cell->item());
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return value;
+    }
+
+    std::size_t capacity() const { return mask + 1; }
+
+    // A snapshot; exact only while no thread pushes or pops
+    std::size_t size() const
+    {
+        std::size_t tail = enqueue_pos.load(std::memory_order_acquire);
+        std::size_t head = dequeue_pos.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return reinterpret_cast<T*>(storage); }
+    };
+
+    static std::size_t round_up(std::size_t n)
+    {
+        std::size_t capacity = 2;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
+    }
+
+    // Read-only after construction
+    alignas(64) const std::size_t mask;
+    Cell* const cells;
+
+    alignas(64) std::atomic<std::size_t> enqueue_pos{0};
+    alignas(64) std::atomic<std::size_t> dequeue_pos{0};
+};
+
+template <typename T>
+class BlockingMpmcQueue
+{
+public:
+    explicit BlockingMpmcQueue(std::size_t capacity_) : queue(capacity_) {}
+
+    template <typename U>
+    bool try_push(U&& value)
+    {
+        if (!queue.try_push(std::forward<U>(value))) return false;
+        not_empty.notify_one(); // Only a load when no consumer sleeps
+        return true;
+    }
+
+    std::optional<T> try_pop()
+    {
+        std::optional<T> value = queue.try_pop();
+        if (value) not_full.notify_one();
+        return value;
+    }
+
+    template <typename U>
+    void push(U&& value)
+    {
+        for (int spins = 0; ; ++spins)
+        {
+            if (try_push(std::forward<U>(value))) return;
+            if (spins < spin_limit)
+            {
+                backoff(spins);
+                continue;
+            }
+
+            // Full: register as a waiter, check once more, then sleep
+            EventCount::Key key = not_full.prepare_wait();
+            if (try_push(std::forward<U>(value)))
+            {
+                not_full.cancel_wait();
+                return;
+            }
+            not_full.wait(key);
+        }
+    }
+
+    T pop()
+    {
+        for (int spins = 0; ; ++spins)
+        {
+            if (std::optional<T> value = try_pop()) return std::move(*value);
+            if (spins < spin_limit)
+            {
+                backoff(spins);
+                continue;
+            }
+
+            EventCount::Key key = not_empty.prepare_wait();
+            if (std::optional<T> value = try_pop())
+            {
+                not_empty.cancel_wait();
+                return std::move(*value);
+            }
+            not_empty.wait(key);
+        }
+    }
+
+    std::size_t capacity() const { return queue.capacity(); }
+    std::size_t size() const { return queue.size(); }
+    bool empty() const { return queue.empty(); }
+
+private:
+    static constexpr int spin_limit = 128;
+
+    static void backoff(int spins)
+    {
+        if (spins < 64) cpu_relax();
+        else std::this_thread::yield();
+    }
+
+    MpmcQueue<T> queue;
+    EventCount not_empty;
+    EventCount not_full;
+};
@@ -0,0 +1,80 @@
+/*
+
+Priority-based producers and consumers
+
+Tasks of three priorities, as in the Leader/Followers example, on a
+PriorityBuffer (priority_buffer.hpp) instead of a std::priority_queue under one
+mutex. The producers first fill the buffer while the workers are held back, so
+the output shows the order in which the levels are served: high-priority tasks
+first, with a low or medium one slipped in every AGING_PERIOD pops so that
+they are not starved.
+
+*/
+
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "priority_buffer.hpp"
+
+const std::size_t LOW = 0, MEDIUM = 1, HIGH = 2;
+const int TASKS_PER_LEVEL = 12;
+const std::uint32_t AGING_PERIOD = 4;
+
+PriorityBuffer<std::function<void()>, 3> buffer(AGING_PERIOD);
+std::latch filled(1);
+
+void producer(std::size_t level, const char* name)
+{
+    for (int i = 0; i < TASKS_PER_LEVEL; ++i)
+    {
+        buffer.push(level, [name, i]
+        {
+            std::ostringstream line;
+            line << "Executing " << name << " priority task " << i << "\n";
+            std::cout << line.str();
+        });
+    }
+}
+
+void worker(int id)
+{
+    filled.wait();
+    while (auto task = buffer.pop())
+    {
+        std::ostringstream line;
+        line << "Thread " << id << " handles a priority " << task->first << " task. ";
+        std::cout << line.str();
+        task->second();
+    }
+}
+
+int main()
+{
+    std::thread producers[] = {
+        std::thread(producer, LOW, "low"),
+        std::thread(producer, MEDIUM, "medium"),
+        std::thread(producer, HIGH, "high"),
+    };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 2; ++i)
+    {
+        workers.emplace_back(worker, i);
+    }
+
+    for (auto& t : producers)
+    {
+        t.join();
+    }
+    filled.count_down();
+    buffer.close();
+
+    for (auto& t : workers)
+    {
+        t.join();
+    }
+
+    return 0;
+}
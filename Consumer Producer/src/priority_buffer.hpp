@@ -0,0 +1,176 @@
+/*
+
+Producer/consumer queue with a fixed number of priority levels
+
+The priority variant of the producer/consumer problem (Semaphore_Mutex.md) and
+the Leader/Followers example keep a std::priority_queue under one mutex: every
+push and every pop is an O(log n) heap operation inside the lock.
+PriorityBuffer<T, Levels> trades arbitrary priorities for a small fixed number
+of levels (0 = lowest, Levels - 1 = highest) and makes both operations O(1):
+
+- Every level is its own lock-free FIFO, a SegmentedQueue (segmented_queue.hpp),
+  so producers of different levels never touch the same line and items of equal
+  priority come out in push order.
+- A bitmap has bit l set while level l may hold items. try_pop finds the
+  highest candidate with one count-leading-zeros; when a level turns out to be
+  empty it masks that bit and looks further down. Per-level counters keep the
+  bitmap exact enough: a level's bit is set by the push that takes its count off
+  zero and cleared, then re-checked, by the pop that brings it back to zero.
+- Aging: every `aging_period`-th pop serves a lower non-empty level instead of
+  the highest one, walking round-robin down through the lower levels. While
+  high-priority work keeps coming, every level still gets a share of roughly
+  1 / (aging_period * levels) of the pops, so nothing waits forever. An
+  aging_period of 0 turns aging off.
+
+pop() spins, yields and then sleeps on an EventCount; it returns std::nullopt
+once the buffer is closed and drained.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <utility>
+#include "cpu_relax.hpp"
+#include "event_count.hpp"
+#include "segmented_queue.hpp"
+
+template <typename T, std::size_t Levels = 8>
+class PriorityBuffer
+{
+    static_assert(Levels > 0 && Levels <= 64, "one bit per level in a 64-bit mask");
+
+public:
+    explicit PriorityBuffer(std::uint32_t aging_period_ = 64) : aging_period(aging_period_) {}
+
+    PriorityBuffer(const PriorityBuffer&) = delete;
+    PriorityBuffer& operator=(const PriorityBuffer&) = delete;
+
+    static constexpr std::size_t levels() { return Levels; }
+
+    // Levels above the highest are clamped to it
+    template <typename U>
+    void push(std::size_t level, U&& value)
+    {
+        if (level >= Levels) level = Levels - 1;
+
+        Level& l = queues[level];
+        l.items.push(std::forward<U>(value));
+        if (l.count.fetch_add(1, std::memory_order_acq_rel) == 0)
+        {
+            nonempty.fetch_or(bit(level), std::memory_order_release);
+        }
+        events.notify_one(); // Only a load when no consumer sleeps
+    }
+
+    // The item and its level
+    std::optional<std::pair<std::size_t, T>> try_pop()
+    {
+        std::uint64_t mask = nonempty.load(std::memory_order_acquire);
+        if (mask == 0) return std::nullopt;
+
+        std::size_t top = highest(mask);
+        if (aging_period && (mask & (bit(top) - 1)) && pops.fetch_add(1, std::memory_order_relaxed) % aging_period == aging_period - 1)
+        {
+            if (auto item = take(aged_level(mask, top))) return item;
+        }
+
+        while (mask)
+        {
+            std::size_t level = highest(mask);
+            if (auto item = take(level)) return item;
+            mask &= ~bit(level); // Emptied meanwhile: look further down
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::pair<std::size_t, T>> pop()
+    {
+        while (true)
+        {
+            for (int round = 0; round < spin_rounds + yield_rounds; ++round)
+            {
+                if (auto item = try_pop()) return item;
+                if (round < spin_rounds) cpu_relax();
+                else std::this_thread::yield();
+            }
+
+            EventCount::Key key = events.prepare_wait();
+            if (auto item = try_pop())
+            {
+                events.cancel_wait();
+                return item;
+            }
+            if (closed.load(std::memory_order_seq_cst)) // seq_cst: pairs with the fence in notify_all
+            {
+                events.cancel_wait();
+                return std::nullopt;
+            }
+            events.wait(key);
+        }
+    }
+
+    void close()
+    {
+        closed.store(true, std::memory_order_release);
+        events.notify_all();
+    }
+
+private:
+    static constexpr int spin_rounds = 16;
+    static constexpr int yield_rounds = 8;
+
+    struct alignas(64) Level
+    {
+        SegmentedQueue<T> items{1};
+        std::atomic<std::size_t> count{0};
+    };
+
+    static constexpr std::uint64_t bit(std::size_t level) { return std::uint64_t(1) << level; }
+    static std::size_t highest(std::uint64_t mask) { return 63 - static_cast<std::size_t>(std::countl_zero(mask)); }
+
+    // The next non-empty level below `top`, going round-robin downwards from the last aged one
+    std::size_t aged_level(std::uint64_t mask, std::size_t top)
+    {
+        std::uint64_t lower = mask & (bit(top) - 1);
+        std::size_t cursor = aging_cursor.load(std::memory_order_relaxed);
+        std::uint64_t below_cursor = lower & (cursor < 64 ? bit(cursor) - 1 : ~std::uint64_t(0));
+        std::size_t level = highest(below_cursor ? below_cursor : lower);
+        aging_cursor.store(level, std::memory_order_relaxed);
+        return level;
+    }
+
+    std::optional<std::pair<std::size_t, T>> take(std::size_t level)
+    {
+        Level& l = queues[level];
+        std::optional<T> value = l.items.try_pop();
+        if (!value) return std::nullopt;
+
+        if (l.count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            nonempty.fetch_and(~bit(level), std::memory_order_acq_rel);
+            // A push may have raised the count and set the bit just before the clear
+            if (l.count.load(std::memory_order_acquire) != 0)
+            {
+                nonempty.fetch_or(bit(level), std::memory_order_release);
+            }
+        }
+        return std::pair<std::size_t, T>(level, std::move(*value));
+    }
+
+    const std::uint32_t aging_period;
+
+    std::array<Level, Levels> queues;
+    alignas(64) std::atomic<std::uint64_t> nonempty{0};
+    alignas(64) std::atomic<std::uint32_t> pops{0};
+    std::atomic<std::size_t> aging_cursor{64};
+
+    EventCount events;
+    std::atomic<bool> closed{false};
+};
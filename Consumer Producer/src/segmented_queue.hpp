@@ -0,0 +1,301 @@
+/*
+
+Segmented unbounded multi-producer / multi-consumer queue
+
+The unbounded buffer of ConsumerProducerUnboundedBuffer.md is a std::queue
+behind one mutex. Under a burst of pushes every deque block it grows by comes
+from the global allocator, inside the lock, and is handed back once drained.
+SegmentedQueue<T> is a linked list of fixed-size array segments, in the style
+of LCRQ and moodycamel::ConcurrentQueue, that never returns memory during use:
+
+- push: one fetch_add on the tail segment's `enqueue_idx` claims a slot; the
+  item is written and the slot marked ready. A producer that gets an index past
+  the end links a new segment and moves `tail` on (other producers help).
+- try_pop: reads the slot at the head segment's `dequeue_idx` and claims it with
+  a CAS once it is ready. When the whole segment has been claimed, `head` moves
+  to the next one.
+- Drained segments go back to a free list and are reused by the next producer
+  that needs one. After a burst the queue keeps its peak size instead of freeing
+  and reallocating it on the next burst; the allocator is only touched when the
+  queue grows beyond anything it has held before.
+
+Segments are reclaimed with a reference count. `head` and `tail` each hold one
+reference; a thread takes one for as long as it works on a segment, and only if
+the count is not already zero. Segments are never freed while the queue
+exists, so a thread holding a stale pointer may still read the count, and
+whoever drops the last reference puts the segment on the free list.
+
+pop() spins, yields and then sleeps on an EventCount; it returns std::nullopt
+once the queue is closed and drained.
+
+Order is FIFO among items whose push has completed. try_pop may report empty
+while the oldest claimed slot is still being written.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "cpu_relax.hpp"
+#include "event_count.hpp"
+
+template <typename T, std::size_t SegmentSize = 1024>
+class SegmentedQueue
+{
+    static_assert(SegmentSize > 0, "segments need at least one slot");
+
+public:
+    explicit SegmentedQueue(std::size_t preallocated = 4)
+    {
+        for (std::size_t i = 0; i < preallocated; ++i)
+        {
+            pool.push_back(new Segment);
+        }
+        allocated.store(preallocated, std::memory_order_relaxed);
+        Segment* first = take_segment();
+        head.store(first, std::memory_order_relaxed);
+        tail.store(first, std::memory_order_relaxed);
+    }
+
+    SegmentedQueue(const SegmentedQueue&) = delete;
+    SegmentedQueue& operator=(const SegmentedQueue&) = delete;
+
+    ~SegmentedQueue()
+    {
+        for (Segment* seg = head.load(std::memory_order_relaxed); seg; )
+        {
+            Segment* next = seg->next.load(std::memory_order_relaxed);
+            std::size_t end = std::min(seg->enqueue_idx.load(std::memory_order_relaxed), SegmentSize);
+            for (std::size_t i = seg->dequeue_idx.load(std::memory_order_relaxed); i < end; ++i)
+            {
+                if (seg->slots[i].ready.load(std::memory_order_relaxed)) std::destroy_at(seg->slots[i].item());
+            }
+            delete seg;
+            seg = next;
+        }
+        for (Segment* seg : pool)
+        {
+            delete seg;
+        }
+    }
+
+    template <typename U>
+    void push(U&& value)
+    {
+        Segment* seg = acquire(tail);
+        for (;;)
+        {
+            std::size_t i = seg->enqueue_idx.fetch_add(1, std::memory_order_relaxed);
+            if (i < SegmentSize)
+            {
+                Slot& slot = seg->slots[i];
+                std::construct_at(slot.item(), std::forward<U>(value));
+                slot.ready.store(true, std::memory_order_release);
+                break;
+            }
+
+            // Full: make sure a next segment exists, move `tail` to it and retry there
+            Segment* next = seg->next.load(std::memory_order_acquire);
+            if (!next)
+            {
+                Segment* fresh = take_segment();
+                if (seg->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    next = fresh;
+                }
+                else
+                {
+                    // Another producer linked one first. Drop both references rather
+                    // than pooling it directly: a stale acquire() may have bumped the count
+                    release(fresh);
+                    release(fresh);
+                }
+            }
+            advance(tail, seg, next);
+            release(seg);
+            seg = acquire(tail);
+        }
+        release(seg);
+        events.notify_one(); // Only a load when no consumer sleeps
+    }
+
+    std::optional<T> try_pop()
+    {
+        Segment* seg = acquire(head);
+        for (;;)
+        {
+            std::size_t i = seg->dequeue_idx.load(std::memory_order_relaxed);
+            if (i < SegmentSize)
+            {
+                Slot& slot = seg->slots[i];
+                if (!slot.ready.load(std::memory_order_acquire))
+                {
+                    release(seg); // Empty, or the oldest push is still writing
+                    return std::nullopt;
+                }
+                if (!seg->dequeue_idx.compare_exchange_weak(i, i + 1, std::memory_order_relaxed)) continue;
+
+                std::optional<T> value(std::move(*slot.item()));
+                std::destroy_at(slot.item());
+                release(seg);
+                return value;
+            }
+
+            // Every slot claimed: move on once producers have linked the next segment
+            Segment* next = seg->next.load(std::memory_order_acquire);
+            if (!next)
+            {
+                release(seg);
+                return std::nullopt;
+            }
+            advance(head, seg, next);
+            release(seg);
+            seg = acquire(head);
+        }
+    }
+
+    std::optional<T> pop()
+    {
+        while (true)
+        {
+            // Items usually arrive within a few microseconds under load: spin, then yield, then sleep
+            for (int round = 0; round < spin_rounds + yield_rounds; ++round)
+            {
+                if (std::optional<T> value = try_pop()) return value;
+                if (round < spin_rounds) cpu_relax();
+                else std::this_thread::yield();
+            }
+
+            EventCount::Key key = events.prepare_wait();
+            if (std::optional<T> value = try_pop())
+            {
+                events.cancel_wait();
+                return value;
+            }
+            if (closed.load(std::memory_order_seq_cst)) // seq_cst: pairs with the fence in notify_all
+            {
+                events.cancel_wait();
+                return std::nullopt;
+            }
+            events.wait(key);
+        }
+    }
+
+    void close()
+    {
+        closed.store(true, std::memory_order_release);
+        events.notify_all();
+    }
+
+    // Segments currently linked plus those waiting in the free list
+    std::size_t allocated_segments() const
+    {
+        return allocated.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int spin_rounds = 16;
+    static constexpr int yield_rounds = 8;
+
+    struct Slot
+    {
+        std::atomic<bool> ready{false};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return reinterpret_cast<T*>(storage); }
+    };
+
+    struct Segment
+    {
+        alignas(64) std::atomic<std::size_t> enqueue_idx{0};
+        alignas(64) std::atomic<std::size_t> dequeue_idx{0};
+        alignas(64) std::atomic<std::size_t> refs{0};
+        std::atomic<Segment*> next{nullptr};
+        Slot slots[SegmentSize];
+    };
+
+    // Takes a reference to the segment `ptr` points to
+    Segment* acquire(std::atomic<Segment*>& ptr)
+    {
+        for (;;)
+        {
+            Segment* seg = ptr.load(std::memory_order_acquire);
+            std::size_t refs = seg->refs.load(std::memory_order_relaxed);
+            while (refs != 0 && !seg->refs.compare_exchange_weak(refs, refs + 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+            }
+            if (refs == 0) continue; // Already on its way to the free list
+
+            if (ptr.load(std::memory_order_acquire) == seg) return seg;
+            release(seg); // Moved on meanwhile
+        }
+    }
+
+    // Moves `ptr` from `seg` to `next`; the winner drops the reference `ptr` held
+    void advance(std::atomic<Segment*>& ptr, Segment* seg, Segment* next)
+    {
+        if (ptr.compare_exchange_strong(seg, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            release(seg);
+        }
+    }
+
+    void release(Segment* seg)
+    {
+        if (seg->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) give_back(seg);
+    }
+
+    Segment* take_segment()
+    {
+        Segment* seg = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(pool_mtx);
+            if (!pool.empty())
+            {
+                seg = pool.back();
+                pool.pop_back();
+            }
+        }
+        if (!seg)
+        {
+            seg = new Segment;
+            allocated.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        seg->enqueue_idx.store(0, std::memory_order_relaxed);
+        seg->dequeue_idx.store(0, std::memory_order_relaxed);
+        seg->next.store(nullptr, std::memory_order_relaxed);
+        for (Slot& slot : seg->slots)
+        {
+            slot.ready.store(false, std::memory_order_relaxed);
+        }
+        seg->refs.store(2, std::memory_order_release); // One for `head`, one for `tail`
+        return seg;
+    }
+
+    // Segments in the pool always have refs == 0, so acquire() never revives one
+    void give_back(Segment* seg)
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        pool.push_back(seg);
+    }
+
+    alignas(64) std::atomic<Segment*> head{nullptr};
+    alignas(64) std::atomic<Segment*> tail{nullptr};
+
+    // Touched once per segment, not per item
+    alignas(64) std::mutex pool_mtx;
+    std::vector<Segment*> pool;
+    std::atomic<std::size_t> allocated{0};
+
+    EventCount events;
+    std::atomic<bool> closed{false};
+};
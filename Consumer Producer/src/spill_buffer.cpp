@@ -0,0 +1,63 @@
+/*
+
+Unbounded buffer with spill-to-disk overflow
+
+A producer and a consumer on a SpillBuffer (spill_buffer.hpp). The consumer
+stalls for a while, as during an outage of whatever it feeds: the first
+MEMORY_LIMIT items stay in memory, the rest go to segment files in the temp
+directory, and once the consumer is back it reads all of them in order.
+
+*/
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "spill_buffer.hpp"
+
+using namespace std::chrono_literals;
+
+const std::size_t MEMORY_LIMIT = 8;
+const int ITEMS = 40;
+
+// Tiny segments, so that the example goes through several files
+SpillBuffer<int> buffer(MEMORY_LIMIT, std::filesystem::temp_directory_path(), 16 * sizeof(int));
+
+void producer()
+{
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        buffer.push(i);
+
+        std::ostringstream line;
+        line << "Producer produced " << i << " (memory " << buffer.in_memory() << ", disk " << buffer.on_disk() << ")\n";
+        std::cout << line.str();
+    }
+}
+
+void consumer()
+{
+    std::this_thread::sleep_for(50ms); // Outage
+
+    int expected = 0;
+    while (std::optional<int> item = buffer.pop())
+    {
+        std::ostringstream line;
+        line << "Consumer consumed " << *item << (*item == expected ? "" : " (out of order)") << "\n";
+        std::cout << line.str();
+        ++expected;
+    }
+}
+
+int main()
+{
+    std::thread producerThread(producer);
+    std::thread consumerThread(consumer);
+
+    producerThread.join();
+    buffer.close();
+    consumerThread.join();
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+
+Unbounded buffer that spills to disk
+
+The std::queue of ConsumerProducerUnboundedBuffer.md grows until the process
+runs out of memory when the consumers stall. SpillBuffer<T> keeps at most
+`memory_limit` items in RAM; beyond that, push() appends to segment files on
+local disk and never blocks or drops an item:
+
+- Items in memory are always older than items on disk. Once spilling starts,
+  new items keep going to disk until the consumers have read the disk back, so
+  pop() returns everything in push order.
+- Each segment file is mapped with mmap and written and read with plain
+  copies; a write is a copy into the page cache, and the kernel writes the
+  pages back and evicts them under memory pressure.
+- A segment file is unlinked right after it is created, so nothing is left
+  behind when the process dies, and its space is released once the consumers
+  have read it and it is closed. The last segment is kept and rewound when the
+  disk runs empty, and one fully read segment is kept as a spare for the next
+  one, so a steady trickle of overflow does not create and delete files.
+- Disk space for a segment is reserved when the segment is created; running
+  out of it, or failing to create the file, throws std::system_error from push().
+  The file is created, reserved and mapped without holding the mutex, so the
+  consumers and the other producers are not stalled behind the disk meanwhile;
+  only one producer at a time creates a segment, the others wait for it.
+
+Items are copied to disk byte for byte, so T must be trivially copyable. One
+mutex guards the buffer as in the original; consumers are only notified when
+one of them waits.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+template <typename T>
+class SpillBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "spilled items are copied to disk byte for byte");
+
+public:
+    SpillBuffer(std::size_t memory_limit_, std::filesystem::path directory_,
+                std::size_t segment_bytes = std::size_t(64) << 20)
+        : memory_limit(memory_limit_),
+          directory(std::move(directory_)),
+          segment_items(std::max<std::size_t>(segment_bytes / sizeof(T), 1))
+    {
+    }
+
+    SpillBuffer(const SpillBuffer&) = delete;
+    SpillBuffer& operator=(const SpillBuffer&) = delete;
+
+    ~SpillBuffer()
+    {
+        for (Segment& segment : segments)
+        {
+            unmap(segment);
+        }
+        if (spare) unmap(*spare);
+    }
+
+    void push(const T& value)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (spilled == 0 && memory.size() < memory_limit)
+        {
+            memory.push_back(value);
+        }
+        else
+        {
+            spill(value, lock);
+        }
+        if (waiting_consumers) cv.notify_one();
+    }
+
+    std::optional<T> try_pop()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return take();
+    }
+
+    // Waits for an item; returns std::nullopt once the buffer is closed and drained
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        ++waiting_consumers;
+        cv.wait(lock, [this] { return closed || !memory.empty() || spilled != 0; });
+        --waiting_consumers;
+        return take();
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        cv.notify_all();
+    }
+
+    std::size_t in_memory() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return memory.size();
+    }
+
+    std::size_t on_disk() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return spilled;
+    }
+
+private:
+    struct Segment
+    {
+        int fd = -1;
+        T* items = nullptr;
+        std::size_t write_pos = 0;
+        std::size_t read_pos = 0;
+    };
+
+    // Called with the lock held
+    std::optional<T> take()
+    {
+        if (!memory.empty())
+        {
+            std::optional<T> value(std::move(memory.front()));
+            memory.pop_front();
+            return value;
+        }
+        if (spilled == 0) return std::nullopt;
+
+        Segment& front = segments.front();
+        std::optional<T> value(front.items[front.read_pos++]);
+        --spilled;
+
+        if (front.read_pos == front.write_pos)
+        {
+            front.read_pos = front.write_pos = 0;
+            if (segments.size() > 1)
+            {
+                // No longer written either: keep it for the next segment, or give the disk space back
+                if (spare) unmap(front);
+                else spare = front;
+                segments.pop_front();
+            }
+            // Otherwise the disk is empty and the file is reused
+        }
+        return value;
+    }
+
+    // Called with the lock held; may release it while a new segment is created
+    void spill(const T& value, std::unique_lock<std::mutex>& lock)
+    {
+        while (segments.empty() || segments.back().write_pos == segment_items)
+        {
+            if (spare)
+            {
+                segments.push_back(*spare);
+                spare.reset();
+            }
+            else if (growing)
+            {
+                grown.wait(lock, [this] { return !growing; });
+            }
+            else
+            {
+                // Goes through `spare`: a consumer may have rewound the last segment meanwhile
+                Segment segment = grow(lock);
+                if (spare) unmap(segment);
+                else spare = segment;
+            }
+        }
+        Segment& back = segments.back();
+        std::construct_at(&back.items[back.write_pos++], value);
+        ++spilled;
+    }
+
+    // Maps a new segment with the lock released; the other producers that need one wait on `grown`
+    Segment grow(std::unique_lock<std::mutex>& lock)
+    {
+        growing = true;
+        lock.unlock();
+        Segment segment;
+        try
+        {
+            segment = map_new_segment();
+        }
+        catch (...)
+        {
+            lock.lock();
+            growing = false;
+            grown.notify_all();
+            throw;
+        }
+        lock.lock();
+        growing = false;
+        grown.notify_all();
+        return segment;
+    }
+
+    Segment map_new_segment()
+    {
+        std::string name = (directory / "spill-XXXXXX").string();
+        Segment segment;
+        segment.fd = ::mkstemp(name.data());
+        if (segment.fd < 0) throw std::system_error(errno, std::generic_category(), "cannot create " + name);
+        ::unlink(name.c_str()); // Anonymous from now on; the space goes away with the descriptor
+
+        // Reserve the blocks up front: a full disk is reported here instead of as SIGBUS on a later write
+        std::size_t bytes = segment_items * sizeof(T);
+        int error = ::posix_fallocate(segment.fd, 0, static_cast<off_t>(bytes));
+        void* data = MAP_FAILED;
+        if (error == 0)
+        {
+            data = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, segment.fd, 0);
+            if (data == MAP_FAILED) error = errno;
+        }
+        if (data == MAP_FAILED)
+        {
+            ::close(segment.fd);
+            throw std::system_error(error, std::generic_category(), "cannot map a spill segment");
+        }
+        segment.items = static_cast<T*>(data);
+        return segment;
+    }
+
+    void unmap(Segment& segment)
+    {
+        ::munmap(segment.items, segment_items * sizeof(T));
+        ::close(segment.fd);
+    }
+
+    const std::size_t memory_limit;
+    const std::filesystem::path directory;
+    const std::size_t segment_items;
+
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    std::condition_variable grown;
+    std::deque<T> memory;
+    std::deque<Segment> segments; // Oldest first; only the last one is written
+    std::optional<Segment> spare; // Fully read, rewound, not in `segments`
+    std::size_t spilled = 0;
+    std::size_t waiting_consumers = 0;
+    bool growing = false; // A producer is creating a segment without the lock
+    bool closed = false;
+};
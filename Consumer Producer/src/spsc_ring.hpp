@@ -0,0 +1,211 @@
+/*
+
+Single-producer / single-consumer ring buffer
+
+The bounded buffer of ConsumerProducerBoundedBuffer.md pays a mutex and a
+notify_all() for every int. With exactly one producer thread and one consumer
+thread no lock is needed at all:
+
+- Only the producer writes `tail` and only the consumer writes `head`, so each
+  side publishes its progress with one release store and never retries. Both
+  try_push and try_pop are wait-free.
+- The capacity is a power of two, so a slot index is `position & mask`. The
+  positions themselves only ever increase, so full and empty are told apart
+  without wasting a slot.
+- `head` and `tail` live on separate cache lines. Each side also keeps a cached
+  copy of the other side's index on its own line and only re-reads the shared
+  one when the cached value says the ring is full (producer) or empty
+  (consumer). In steady state a push touches no line the consumer writes.
+- try_push_n / try_pop_n move up to n items with a single index update, so a
+  batch costs one cache-line transfer instead of n.
+
+push() and pop() wait for room or for an item, spinning and then yielding. They
+are for drop-in use where the mutex version blocked; they are not wait-free.
+
+Using one SpscRing from two producers or two consumers is a data race.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include "cpu_relax.hpp"
+
+template <typename T>
+class SpscRing
+{
+public:
+    // The capacity is rounded up to a power of two
+    explicit SpscRing(std::size_t capacity_)
+        : mask(round_up(capacity_) - 1),
+          slots(std::allocator<T>().allocate(mask + 1))
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    ~SpscRing()
+    {
+        for (std::size_t i = head.load(std::memory_order_relaxed); i != tail.load(std::memory_order_relaxed); ++i)
+        {
+            std::destroy_at(&slots[i & mask]);
+        }
+        std::allocator<T>().deallocate(slots, mask + 1);
+    }
+
+    // Producer side
+
+    template <typename U>
+    bool try_push(U&& value)
+    {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (room(t) == 0) return false;
+
+        std::construct_at(&slots[t & mask], std::forward<U>(value));
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Copies up to `count` items from `first` (pass a std::move_iterator to move them);
+    // returns how many were pushed
+    template <typename InputIt>
+    std::size_t try_push_n(InputIt first, std::size_t count)
+    {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        std::size_t n = std::min(count, room(t, count));
+
+        for (std::size_t i = 0; i < n; ++i, ++first)
+        {
+            std::construct_at(&slots[(t + i) & mask], *first);
+        }
+        if (n) tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    template <typename U>
+    void push(U&& value)
+    {
+        for (int spins = 0; !try_push(std::forward<U>(value)); )
+        {
+            backoff(spins);
+        }
+    }
+
+    // Consumer side
+
+    std::optional<T> try_pop()
+    {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (available(h) == 0) return std::nullopt;
+
+        T& slot = slots[h & mask];
+        std::optional<T> value(std::move(slot));
+        std::destroy_at(&slot);
+        head.store(h + 1, std::memory_order_release);
+        return value;
+    }
+
+    // Moves up to `max` items to `out`; returns how many were popped
+    template <typename OutputIt>
+    std::size_t try_pop_n(OutputIt out, std::size_t max)
+    {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        std::size_t n = std::min(max, available(h, max));
+
+        for (std::size_t i = 0; i < n; ++i, ++out)
+        {
+            T& slot = slots[(h + i) & mask];
+            *out = std::move(slot);
+            std::destroy_at(&slot);
+        }
+        if (n) head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    T pop()
+    {
+        for (int spins = 0; ; )
+        {
+            if (std::optional<T> value = try_pop()) return std::move(*value);
+            backoff(spins);
+        }
+    }
+
+    // Either side
+
+    std::size_t capacity() const { return mask + 1; }
+
+    // Exact when called from the producer or the consumer with the other side idle
+    std::size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    static std::size_t round_up(std::size_t n)
+    {
+        std::size_t capacity = 1;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
+    }
+
+    static void backoff(int& spins)
+    {
+        if (spins < 64)
+        {
+            ++spins;
+            cpu_relax();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // Free slots seen by the producer at position t; re-reads `head` only if the
+    // cached copy shows fewer than `wanted`
+    std::size_t room(std::size_t t, std::size_t wanted = 1)
+    {
+        std::size_t free = capacity() - (t - cached_head);
+        if (free < wanted)
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            free = capacity() - (t - cached_head);
+        }
+        return free;
+    }
+
+    // Items seen by the consumer at position h; re-reads `tail` only if the
+    // cached copy shows fewer than `wanted`
+    std::size_t available(std::size_t h, std::size_t wanted = 1)
+    {
+        std::size_t ready = cached_tail - h;
+        if (ready < wanted)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            ready = cached_tail - h;
+        }
+        return ready;
+    }
+
+    // Read-only after construction
+    alignas(64) const std::size_t mask;
+    T* const slots;
+
+    // Written by the consumer
+    alignas(64) std::atomic<std::size_t> head{0};
+    std::size_t cached_tail = 0;
+
+    // Written by the producer; the class alignment keeps whatever follows the ring off this line
+    alignas(64) std::atomic<std::size_t> tail{0};
+    std::size_t cached_head = 0;
+};
@@ -0,0 +1,72 @@
+/*
+
+Unbounded buffer on a segmented lock-free queue
+
+The two producers and two consumers of ConsumerProducerUnboundedBuffer.md on a
+SegmentedQueue (segmented_queue.hpp) instead of std::queue + mutex + condition
+variable:
+
+- Producers claim slots with one fetch_add and never wait.
+- The queue grows in segments of SEGMENT_SIZE items; drained segments are kept
+  on a free list and reused, so a second burst allocates nothing.
+- main() closes the queue once the producers are done, so the consumers end
+  instead of being detached.
+
+*/
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "segmented_queue.hpp"
+
+const std::size_t SEGMENT_SIZE = 8;
+
+SegmentedQueue<int, SEGMENT_SIZE> buffer(1);
+
+void producer(int id)
+{
+    for (int i = 0; i < 10; ++i)
+    {
+        buffer.push(i);
+
+        std::ostringstream line;
+        line << "Producer " << id << " produced " << i << "\n";
+        std::cout << line.str();
+    }
+}
+
+void consumer(int id)
+{
+    while (std::optional<int> item = buffer.pop())
+    {
+        std::ostringstream line;
+        line << "Consumer " << id << " consumed " << *item << "\n";
+        std::cout << line.str();
+    }
+}
+
+int main()
+{
+    std::thread producers[2];
+    std::thread consumers[2];
+
+    for (int i = 0; i < 2; ++i)
+    {
+        producers[i] = std::thread(producer, i);
+        consumers[i] = std::thread(consumer, i);
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        producers[i].join();
+    }
+
+    buffer.close();
+    for (int i = 0; i < 2; ++i)
+    {
+        consumers[i].join();
+    }
+
+    std::cout << "Segments allocated: " << buffer.allocated_segments() << "\n";
+    return 0;
+}
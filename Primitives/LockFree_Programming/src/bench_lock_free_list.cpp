@@ -0,0 +1,120 @@
+/*
+
+Benchmark of concurrent sorted sets
+
+MutexSet  : std::set behind a std::mutex.
+HazardSet : lock_free_list.hpp with HazardPointers.
+EpochSet  : lock_free_list.hpp with EpochReclaimer.
+
+BM_mixed : every thread runs a random mix of 80% contains, 10% insert and 10%
+remove on keys drawn from [0, range), starting from a set that holds half of
+them. Arguments: the key range (twice the list length) and the number of
+threads, each running `ops` operations. Reports operations/s.
+
+*/
+
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "epoch_reclaimer.hpp"
+#include "hazard_pointers.hpp"
+#include "lock_free_list.hpp"
+
+namespace
+{
+
+const std::int64_t ops = 1 << 16;
+
+class MutexSet
+{
+public:
+    bool insert(int key)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return set.insert(key).second;
+    }
+
+    bool remove(int key)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return set.erase(key) == 1;
+    }
+
+    bool contains(int key)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return set.count(key) == 1;
+    }
+
+private:
+    std::mutex mtx;
+    std::set<int> set;
+};
+
+using HazardSet = LockFreeList<int, HazardPointers>;
+using EpochSet = LockFreeList<int, EpochReclaimer>;
+
+template <typename Set>
+void BM_mixed(benchmark::State& state)
+{
+    const int range = static_cast<int>(state.range(0));
+    const int threads = static_cast<int>(state.range(1));
+    Set set;
+    for (int k = 0; k < range; k += 2)
+    {
+        set.insert(k);
+    }
+
+    for (auto _ : state)
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&set, range, t]
+            {
+                std::mt19937 rng(static_cast<std::uint32_t>(t) + 1);
+                std::uniform_int_distribution<int> key(0, range - 1);
+                std::uniform_int_distribution<int> op(0, 9);
+                for (std::int64_t i = 0; i < ops; ++i)
+                {
+                    int k = key(rng);
+                    switch (op(rng))
+                    {
+                    case 0: benchmark::DoNotOptimize(set.insert(k)); break;
+                    case 1: benchmark::DoNotOptimize(set.remove(k)); break;
+                    default: benchmark::DoNotOptimize(set.contains(k)); break;
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * threads * ops);
+}
+
+void ranges_and_threads(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"range", "threads"});
+    for (int range : {64, 1024})
+    {
+        for (int threads : {1, 2, 4, 8})
+        {
+            b->Args({range, threads});
+        }
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_mixed, MutexSet)->Apply(ranges_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_mixed, HazardSet)->Apply(ranges_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_mixed, EpochSet)->Apply(ranges_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,104 @@
+/*
+
+Benchmark of concurrent FIFO queues
+
+MutexQueue    : std::queue behind a std::mutex.
+LockFreeQueue : lock_free_queue.hpp, Michael-Scott with tagged indices.
+
+BM_producers_consumers : the argument is the number of producer threads and
+the number of consumer threads; `items` integers in total go from the producers
+to the consumers, consumers spinning on an empty queue. Reports items/s.
+
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "lock_free_queue.hpp"
+
+namespace
+{
+
+const std::int64_t items = 1 << 18;
+
+template <typename T>
+class MutexQueue
+{
+public:
+    void enqueue(T const& value)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push(value);
+    }
+
+    std::optional<T> dequeue()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (queue.empty()) return std::nullopt;
+        T value = queue.front();
+        queue.pop();
+        return value;
+    }
+
+private:
+    std::mutex mtx;
+    std::queue<T> queue;
+};
+
+template <typename Queue>
+void BM_producers_consumers(benchmark::State& state)
+{
+    const int pairs = static_cast<int>(state.range(0));
+    const std::int64_t per_producer = items / pairs;
+    Queue queue;
+
+    for (auto _ : state)
+    {
+        std::atomic<std::int64_t> remaining{per_producer * pairs};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < pairs; ++p)
+        {
+            threads.emplace_back([&queue, per_producer]
+            {
+                for (std::int64_t i = 0; i < per_producer; ++i)
+                {
+                    queue.enqueue(i);
+                }
+            });
+            threads.emplace_back([&queue, &remaining]
+            {
+                while (remaining.load(std::memory_order_relaxed) > 0)
+                {
+                    if (queue.dequeue()) remaining.fetch_sub(1, std::memory_order_relaxed);
+                    else std::this_thread::yield();
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * per_producer * pairs);
+}
+
+void pair_counts(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("pairs");
+    for (int pairs : {1, 2, 4})
+    {
+        b->Arg(pairs);
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_producers_consumers, MutexQueue<std::int64_t>)->Apply(pair_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_producers_consumers, LockFreeQueue<std::int64_t>)->Apply(pair_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
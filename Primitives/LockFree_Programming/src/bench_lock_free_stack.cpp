@@ -0,0 +1,141 @@
+/*
+
+Benchmark of concurrent stacks
+
+SharedPtrStack : the LockFreeStack of LockFreeProgramming.md, head in a
+                 std::atomic<std::shared_ptr<Node>> (pop returns the value
+                 instead of a std::shared_ptr copy of it).
+MutexStack     : std::vector behind a std::mutex.
+LockFreeStack  : lock_free_stack.hpp with HazardPointers or EpochReclaimer,
+                 with the elimination array (HazardStack, EpochStack) or
+                 without it (HazardTreiber).
+
+BM_push_pop : every thread pushes a value and pops one, `ops` times. The
+argument is the number of threads. Reports push/pop pairs per second.
+
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "epoch_reclaimer.hpp"
+#include "hazard_pointers.hpp"
+#include "lock_free_stack.hpp"
+
+namespace
+{
+
+const std::int64_t ops = 1 << 16;
+
+template <typename T>
+class SharedPtrStack
+{
+public:
+    void push(T const& data)
+    {
+        std::shared_ptr<Node> new_node = std::make_shared<Node>(data);
+        new_node->next = head.load();
+        while (!head.compare_exchange_weak(new_node->next, new_node));
+    }
+
+    std::optional<T> pop()
+    {
+        std::shared_ptr<Node> old_head = head.load();
+        while (old_head && !head.compare_exchange_weak(old_head, old_head->next));
+        return old_head ? std::optional<T>(old_head->data) : std::nullopt;
+    }
+
+private:
+    struct Node
+    {
+        T data;
+        std::shared_ptr<Node> next;
+        Node(T const& data_) : data(data_) {}
+    };
+
+    std::atomic<std::shared_ptr<Node>> head;
+};
+
+template <typename T>
+class MutexStack
+{
+public:
+    void push(T const& value)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        items.push_back(value);
+    }
+
+    std::optional<T> pop()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (items.empty()) return std::nullopt;
+        T value = items.back();
+        items.pop_back();
+        return value;
+    }
+
+private:
+    std::mutex mtx;
+    std::vector<T> items;
+};
+
+template <typename Stack>
+void BM_push_pop(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+
+    for (auto _ : state)
+    {
+        Stack stack;
+        std::atomic<std::int64_t> popped{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&stack, &popped]
+            {
+                std::int64_t count = 0;
+                for (std::int64_t i = 0; i < ops; ++i)
+                {
+                    stack.push(i);
+                    if (stack.pop()) ++count;
+                }
+                popped.fetch_add(count, std::memory_order_relaxed);
+            });
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        benchmark::DoNotOptimize(popped.load());
+    }
+    state.SetItemsProcessed(state.iterations() * threads * ops);
+}
+
+void thread_counts(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("threads");
+    for (int threads : {1, 2, 4, 8})
+    {
+        b->Arg(threads);
+    }
+}
+
+using HazardStack = LockFreeStack<std::int64_t, HazardPointers>;
+using EpochStack = LockFreeStack<std::int64_t, EpochReclaimer>;
+using HazardTreiber = LockFreeStack<std::int64_t, HazardPointers, 0>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_push_pop, SharedPtrStack<std::int64_t>)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_push_pop, MutexStack<std::int64_t>)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_push_pop, HazardTreiber)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_push_pop, HazardStack)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_push_pop, EpochStack)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,296 @@
+/*
+
+Benchmark of concurrent hash maps
+
+MutexMap       : std::unordered_map behind a std::mutex; find copies the value.
+SharedPtrTable : the LockFreeHashTable of LockFreeProgramming.md, 1024 buckets
+                 of std::atomic<std::shared_ptr>; lookup allocates a copy.
+HazardMap      : split_ordered_map.hpp with HazardPointers.
+EpochMap       : split_ordered_map.hpp with EpochReclaimer.
+
+BM_grow  : every thread inserts its own `per_thread` keys into an empty map;
+           the argument is the number of threads. Shows the cost of growing
+           from one bucket, and of never growing.
+BM_find  : every thread looks up `per_thread` random keys in a map holding
+           `keys` keys, half of the lookups missing.
+BM_mixed : 90% find, 5% insert_or_assign and 5% erase on random keys from a
+           map that starts with half of 2 * `keys` keys.
+
+The second argument of BM_find and BM_mixed is the number of threads. Reports
+operations/s and allocs/op, the number of calls to the global operator new per
+operation.
+
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "epoch_reclaimer.hpp"
+#include "hazard_pointers.hpp"
+#include "split_ordered_map.hpp"
+
+namespace
+{
+
+std::atomic<std::int64_t> allocations{0};
+
+} // namespace
+
+// Every call is counted for allocs/op
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+const std::int64_t per_thread = 1 << 15;
+const std::uint64_t keys = 1 << 16;
+
+class MutexMap
+{
+public:
+    bool insert(std::uint64_t key, std::uint64_t value)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return map.emplace(key, value).second;
+    }
+
+    bool insert_or_assign(std::uint64_t key, std::uint64_t value)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return map.insert_or_assign(key, value).second;
+    }
+
+    bool erase(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return map.erase(key) == 1;
+    }
+
+    std::optional<std::uint64_t> find(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = map.find(key);
+        return it == map.end() ? std::nullopt : std::optional<std::uint64_t>(it->second);
+    }
+
+private:
+    std::mutex mtx;
+    std::unordered_map<std::uint64_t, std::uint64_t> map;
+};
+
+template <typename K, typename V>
+class SharedPtrTable
+{
+public:
+    SharedPtrTable() : buckets(1024) {}
+
+    bool insert(K const& key, V const& value)
+    {
+        size_t index = std::hash<K>{}(key) % buckets.size();
+        std::shared_ptr<Node> new_node = std::make_shared<Node>(key, value);
+        new_node->next = buckets[index].load();
+        while (!buckets[index].compare_exchange_weak(new_node->next, new_node));
+        return true;
+    }
+
+    std::shared_ptr<V> find(K const& key)
+    {
+        size_t index = std::hash<K>{}(key) % buckets.size();
+        std::shared_ptr<Node> curr = buckets[index].load();
+        while (curr)
+        {
+            if (curr->key == key) return std::make_shared<V>(curr->value);
+            curr = curr->next;
+        }
+        return nullptr;
+    }
+
+private:
+    struct Node
+    {
+        K key;
+        V value;
+        std::shared_ptr<Node> next;
+        Node(K const& key_, V const& value_) : key(key_), value(value_) {}
+    };
+
+    std::vector<std::atomic<std::shared_ptr<Node>>> buckets;
+};
+
+using HazardMap = SplitOrderedMap<std::uint64_t, std::uint64_t, HazardPointers>;
+using EpochMap = SplitOrderedMap<std::uint64_t, std::uint64_t, EpochReclaimer>;
+
+template <typename Map>
+std::uint64_t lookup(Map& map, std::uint64_t key)
+{
+    auto ref = map.find(key);
+    return ref ? *ref : 0;
+}
+
+template <typename F>
+void in_parallel(int threads, F f)
+{
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back(f, t);
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void report(benchmark::State& state, std::int64_t allocs_before, std::int64_t operations)
+{
+    state.SetItemsProcessed(operations);
+    state.counters["allocs/op"] = static_cast<double>(allocations.load() - allocs_before) / static_cast<double>(operations);
+}
+
+template <typename Map>
+void BM_grow(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+    std::int64_t allocs = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming(); // Construction and destruction stay out of the timing
+        auto map = std::make_unique<Map>();
+        state.ResumeTiming();
+
+        std::int64_t before = allocations.load();
+        in_parallel(threads, [&map](int t)
+        {
+            for (std::int64_t i = 0; i < per_thread; ++i)
+            {
+                std::uint64_t key = static_cast<std::uint64_t>(t * per_thread + i);
+                map->insert(key, key);
+            }
+        });
+        allocs += allocations.load() - before;
+
+        state.PauseTiming();
+        map.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * threads * per_thread);
+    state.counters["allocs/op"] = static_cast<double>(allocs) / static_cast<double>(state.iterations() * threads * per_thread);
+}
+
+template <typename Map>
+void BM_find(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(1));
+    Map map;
+    for (std::uint64_t key = 0; key < keys; ++key)
+    {
+        map.insert(key, key);
+    }
+    in_parallel(threads, [&map](int) { lookup(map, 0); }); // Warm-up: per-thread records
+
+    std::int64_t before = allocations.load();
+    for (auto _ : state)
+    {
+        in_parallel(threads, [&map](int t)
+        {
+            std::mt19937_64 rng(static_cast<std::uint64_t>(t) + 1);
+            std::uint64_t sum = 0;
+            for (std::int64_t i = 0; i < per_thread; ++i)
+            {
+                sum += lookup(map, rng() % (2 * keys));
+            }
+            benchmark::DoNotOptimize(sum);
+        });
+    }
+    report(state, before, state.iterations() * threads * per_thread);
+}
+
+template <typename Map>
+void BM_mixed(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(1));
+    Map map;
+    for (std::uint64_t key = 0; key < 2 * keys; key += 2)
+    {
+        map.insert(key, key);
+    }
+    in_parallel(threads, [&map](int) { lookup(map, 0); });
+
+    std::int64_t before = allocations.load();
+    std::uint64_t round = 0;
+    for (auto _ : state)
+    {
+        ++round; // A fresh sequence every round, so the map keeps changing
+        in_parallel(threads, [&map, threads, round](int t)
+        {
+            std::mt19937_64 rng(round * static_cast<std::uint64_t>(threads) + static_cast<std::uint64_t>(t));
+            std::uint64_t sum = 0;
+            for (std::int64_t i = 0; i < per_thread; ++i)
+            {
+                std::uint64_t r = rng();
+                std::uint64_t key = (r >> 8) % (2 * keys);
+                switch (r % 20)
+                {
+                case 0: map.insert_or_assign(key, r); break;
+                case 1: map.erase(key); break;
+                default: sum += lookup(map, key); break;
+                }
+            }
+            benchmark::DoNotOptimize(sum);
+        });
+    }
+    report(state, before, state.iterations() * threads * per_thread);
+}
+
+void thread_counts(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("threads");
+    for (int threads : {1, 2, 4, 8})
+    {
+        b->Arg(threads);
+    }
+}
+
+void keys_and_threads(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"keys", "threads"});
+    for (int threads : {1, 2, 4, 8})
+    {
+        b->Args({static_cast<std::int64_t>(keys), threads});
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_grow, MutexMap)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_grow, SharedPtrTable<std::uint64_t, std::uint64_t>)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_grow, HazardMap)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_grow, EpochMap)->Apply(thread_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_find, MutexMap)->Apply(keys_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_find, SharedPtrTable<std::uint64_t, std::uint64_t>)->Apply(keys_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_find, HazardMap)->Apply(keys_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_find, EpochMap)->Apply(keys_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_mixed, MutexMap)->Apply(keys_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_mixed, HazardMap)->Apply(keys_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_mixed, EpochMap)->Apply(keys_and_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,121 @@
+/*
+
+Elimination array for a lock-free stack (Hendler, Shavit & Yerushalmi, 2004)
+
+A push followed by a pop leaves the stack as it was, so a push and a pop that
+run at the same time can hand the item over directly and never touch `head`.
+When a CAS on `head` fails, the operation tries that instead:
+
+- A push offers its node in a random slot of the array and spins briefly. If a
+  pop takes it, both are done; otherwise the push withdraws the offer and goes
+  back to `head`.
+- A pop looks at one random slot and takes the node offered there, if any.
+
+Only a push waits, so a slot is either empty, holds an offered node or is
+marked taken until its pusher clears it. The node handed over never enters
+the stack, so no other thread can reach it and the pop frees it directly.
+
+The number of slots in use adapts to the load. Every failed CAS on `head` adds
+to a contention score, and every offer that times out without a partner
+subtracts from it; `width()` is 1 + score / score_per_slot, up to Slots. Under
+light contention pushes and pops meet on one slot; as the CAS-failure rate
+rises, they spread over more slots and stop colliding there as well.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "cpu_relax.hpp"
+
+template <typename Node, std::size_t Slots>
+class EliminationArray
+{
+    static_assert(Slots > 0, "at least one exchange slot");
+
+public:
+    // Offers `node` to a concurrent pop; true if a pop took it
+    bool offer(Node* node)
+    {
+        std::atomic<void*>& slot = slots[pick()].offer;
+        void* expected = nullptr;
+        if (!slot.compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed))
+        {
+            return false; // Slot busy
+        }
+
+        for (int round = 0; round < wait_rounds; ++round)
+        {
+            if (slot.load(std::memory_order_acquire) == taken())
+            {
+                slot.store(nullptr, std::memory_order_release);
+                return true;
+            }
+            cpu_relax();
+        }
+
+        expected = node;
+        if (slot.compare_exchange_strong(expected, nullptr, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            adjust(-1); // Nobody came: the array is wider than the load
+            return false;
+        }
+        slot.store(nullptr, std::memory_order_release); // Taken just before the withdrawal
+        return true;
+    }
+
+    // A node offered by a concurrent push, or nullptr
+    Node* take()
+    {
+        std::atomic<void*>& slot = slots[pick()].offer;
+        void* node = slot.load(std::memory_order_acquire);
+        if (!node || node == taken()) return nullptr;
+        if (!slot.compare_exchange_strong(node, taken(), std::memory_order_acquire, std::memory_order_relaxed)) return nullptr;
+        return static_cast<Node*>(node);
+    }
+
+    // Called by the stack whenever a CAS on its head fails
+    void on_cas_failure() { adjust(+1); }
+
+    std::size_t width() const { return 1 + static_cast<std::size_t>(score.load(std::memory_order_relaxed)) / score_per_slot; }
+
+private:
+    static constexpr int wait_rounds = 64;
+    static constexpr std::size_t score_per_slot = 8;
+    static constexpr std::int32_t max_score = static_cast<std::int32_t>((Slots - 1) * score_per_slot);
+
+    struct alignas(64) Slot
+    {
+        std::atomic<void*> offer{nullptr};
+    };
+
+    static void* taken()
+    {
+        static char marker;
+        return &marker;
+    }
+
+    // A hint only: racing updates may get lost
+    void adjust(std::int32_t delta)
+    {
+        std::int32_t current = score.load(std::memory_order_relaxed);
+        std::int32_t next = current + delta;
+        if (next >= 0 && next <= max_score) score.store(next, std::memory_order_relaxed);
+    }
+
+    std::size_t pick()
+    {
+        thread_local std::uint32_t state = static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1;
+        state ^= state << 13; // xorshift32
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % width();
+    }
+
+    Slot slots[Slots];
+    alignas(64) std::atomic<std::int32_t> score{0};
+};
@@ -0,0 +1,191 @@
+/*
+
+Epoch-based reclamation (Fraser, 2004)
+
+A global epoch counter moves forward one step at a time. Opening a Guard pins
+the thread: it announces the epoch it has seen. A retired node is tagged with
+the epoch current at the time of retirement; once the global epoch is two
+steps further, every thread has been unpinned since the node was unlinked, so
+nobody can still hold a pointer to it.
+
+The epoch only advances when every pinned thread has announced the current
+one. Every `collect_period`-th retire tries to advance it and frees the calling
+thread's nodes that have become old enough.
+
+protect() is a plain acquire load and a guard costs one store and one fence, so
+traversals are cheaper than with hazard pointers. The price is that one thread
+that stays pinned (or is preempted while pinned) blocks all reclamation.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "reclaimer.hpp"
+
+class EpochReclaimer
+{
+    struct Record;
+
+public:
+    static constexpr std::size_t collect_period = 64;
+
+    class Guard
+    {
+    public:
+        Guard() : record(local())
+        {
+            if (record->nesting++ == 0)
+            {
+                record->epoch.store(domain().epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst); // Announcement before any protected load
+            }
+        }
+
+        ~Guard()
+        {
+            if (--record->nesting == 0) record->epoch.store(quiescent, std::memory_order_release);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        template <typename P, typename ToNode = detail::Unmarked>
+        P protect(std::size_t, const std::atomic<P>& src, ToNode = {})
+        {
+            return src.load(std::memory_order_acquire);
+        }
+
+        void set(std::size_t, const void*) {}
+        void reset(std::size_t) {}
+
+    private:
+        Record* record;
+    };
+
+    template <typename T>
+    static void retire(T* p)
+    {
+        retire(p, [](void* object) { delete static_cast<T*>(object); });
+    }
+
+    static void retire(void* p, void (*deleter)(void*))
+    {
+        Record* record = local();
+        std::atomic_thread_fence(std::memory_order_seq_cst); // The caller's unlink before the epoch read; pairs with Guard()
+        record->retired.push_back({{p, deleter}, domain().epoch.load(std::memory_order_relaxed)});
+        if (++record->retires_since_collect >= collect_period) collect(record);
+    }
+
+    // Tries to advance the epoch and frees what the calling thread retired that has become unreachable
+    static void collect() { collect(local()); }
+
+private:
+    static constexpr std::uint64_t quiescent = 0; // The global epoch starts at 1
+
+    struct Retired : detail::Retired
+    {
+        std::uint64_t epoch;
+    };
+
+    struct alignas(64) Record
+    {
+        std::atomic<std::uint64_t> epoch{quiescent};
+        std::atomic<bool> in_use{false};
+        Record* next = nullptr;
+
+        // Used only by the thread that holds the record
+        std::size_t nesting = 0;
+        std::size_t retires_since_collect = 0;
+        bool collecting = false;
+        std::vector<Retired> retired;
+        std::vector<Retired> pending;
+    };
+
+    struct Domain
+    {
+        alignas(64) std::atomic<std::uint64_t> epoch{1};
+        detail::RecordList<Record> records;
+
+        ~Domain()
+        {
+            records.for_each([](Record& record)
+            {
+                for (Retired& r : record.retired)
+                {
+                    r.deleter(r.object);
+                }
+            });
+        }
+    };
+
+    struct Handle
+    {
+        Record* record = domain().records.acquire();
+
+        ~Handle()
+        {
+            collect(record);
+            domain().records.release(record); // Nodes not yet old enough stay with the record
+        }
+    };
+
+    static Domain& domain()
+    {
+        static Domain instance;
+        return instance;
+    }
+
+    static Record* local()
+    {
+        thread_local Handle handle;
+        return handle.record;
+    }
+
+    static void try_advance()
+    {
+        Domain& d = domain();
+        std::uint64_t current = d.epoch.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with the fence in Guard()
+
+        bool behind = false;
+        d.records.for_each([&](Record& record)
+        {
+            std::uint64_t announced = record.epoch.load(std::memory_order_acquire);
+            if (announced != quiescent && announced != current) behind = true;
+        });
+        if (!behind) d.epoch.compare_exchange_strong(current, current + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+
+    static void collect(Record* record)
+    {
+        if (record->collecting) return; // Called from a deleter
+        record->collecting = true;
+        record->retires_since_collect = 0;
+
+        try_advance();
+        std::uint64_t current = domain().epoch.load(std::memory_order_acquire);
+
+        // The list is in retirement order, so the nodes old enough to free form a prefix
+        std::vector<Retired>& retired = record->retired;
+        auto end = std::find_if(retired.begin(), retired.end(), [current](const Retired& r) { return r.epoch + 2 > current; });
+
+        // A deleter may retire more nodes, so free from a separate list
+        std::vector<Retired>& pending = record->pending;
+        pending.assign(retired.begin(), end);
+        retired.erase(retired.begin(), end);
+        for (Retired& r : pending)
+        {
+            r.deleter(r.object);
+        }
+        pending.clear();
+        record->collecting = false;
+    }
+};
+
+static_assert(Reclaimer<EpochReclaimer>);
@@ -0,0 +1,200 @@
+/*
+
+Hazard pointers (Michael, 2004)
+
+Every thread owns `max_depth` blocks of `slots` hazard pointers. A Guard takes
+the next free block of its thread's record and gives it back when it is
+destroyed, so guards nest (up to max_depth deep, innermost released first) and
+an inner guard never clears what an outer one protects. protect() publishes
+the pointer it is about to follow in one of the guard's slots and re-reads the
+source to make sure the node was still linked after the publication; from then
+on the node cannot be freed. retire() puts a node on the thread's retired list.
+Once that list reaches about twice the number of hazard pointers in the
+process, the thread scans: it collects every published pointer, frees the
+retired nodes that are not among them and keeps the rest for the next scan.
+
+At most slots x max_depth x threads nodes are protected at any time, so no more
+than that many retired nodes survive a scan, whatever the other threads do.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "reclaimer.hpp"
+
+class HazardPointers
+{
+    struct Record;
+
+public:
+    static constexpr std::size_t slots = 4;     // Per guard
+    static constexpr std::size_t max_depth = 4; // Guards open at once on one thread
+
+    class Guard
+    {
+    public:
+        // Takes the next block of the thread's slots; guards must be destroyed innermost first
+        Guard() : record(local())
+        {
+            if (record->depth == max_depth) throw std::length_error("hazard-pointer Guards nested too deeply");
+            hazards = record->hazards + record->depth++ * slots;
+        }
+
+        ~Guard()
+        {
+            assert(hazards == record->hazards + (record->depth - 1) * slots && "hazard-pointer Guards released out of order");
+            for (std::size_t slot = 0; slot < slots; ++slot)
+            {
+                hazards[slot].store(nullptr, std::memory_order_release);
+            }
+            --record->depth;
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        // Loads `src` and protects what it points to; to_node maps the loaded value to the node address
+        template <typename P, typename ToNode = detail::Unmarked>
+        P protect(std::size_t slot, const std::atomic<P>& src, ToNode to_node = {})
+        {
+            P p = src.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                hazards[slot].store(to_node(p), std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst); // Publication before the re-check; pairs with scan()
+                P again = src.load(std::memory_order_acquire);
+                if (again == p) return p;
+                p = again;
+            }
+        }
+
+        // `p` must already be protected by another slot of this guard
+        void set(std::size_t slot, const void* p) { hazards[slot].store(p, std::memory_order_release); }
+
+        void reset(std::size_t slot) { hazards[slot].store(nullptr, std::memory_order_release); }
+
+    private:
+        Record* record;
+        std::atomic<const void*>* hazards;
+    };
+
+    template <typename T>
+    static void retire(T* p)
+    {
+        retire(p, [](void* object) { delete static_cast<T*>(object); });
+    }
+
+    static void retire(void* p, void (*deleter)(void*))
+    {
+        Record* record = local();
+        record->retired.push_back({p, deleter});
+        if (!record->scanning && record->retired.size() >= std::max<std::size_t>(64, 2 * slots * max_depth * domain().records.size()))
+        {
+            scan(record);
+        }
+    }
+
+    // Frees whatever the calling thread retired and nobody protects any more
+    static void collect() { scan(local()); }
+
+private:
+    struct alignas(64) Record
+    {
+        std::atomic<const void*> hazards[slots * max_depth] = {};
+        std::atomic<bool> in_use{false};
+        Record* next = nullptr;
+
+        // Used only by the thread that holds the record
+        bool scanning = false;
+        std::size_t depth = 0; // Blocks taken by open guards
+        std::vector<detail::Retired> retired;
+        std::vector<detail::Retired> pending;
+        std::vector<const void*> hazard_snapshot;
+    };
+
+    struct Domain
+    {
+        detail::RecordList<Record> records;
+
+        ~Domain()
+        {
+            records.for_each([](Record& record)
+            {
+                for (detail::Retired& r : record.retired)
+                {
+                    r.deleter(r.object);
+                }
+            });
+        }
+    };
+
+    // Gives the thread's record back when the thread exits
+    struct Handle
+    {
+        Record* record = domain().records.acquire();
+
+        ~Handle()
+        {
+            scan(record);
+            domain().records.release(record); // Nodes still protected stay with the record
+        }
+    };
+
+    static Domain& domain()
+    {
+        static Domain instance;
+        return instance;
+    }
+
+    static Record* local()
+    {
+        thread_local Handle handle;
+        return handle.record;
+    }
+
+    static void scan(Record* record)
+    {
+        if (record->scanning) return; // Called from a deleter
+        record->scanning = true;
+
+        std::atomic_thread_fence(std::memory_order_seq_cst); // Unlinks before the hazard reads; pairs with protect()
+
+        std::vector<const void*>& snapshot = record->hazard_snapshot;
+        snapshot.clear();
+        domain().records.for_each([&snapshot](Record& other)
+        {
+            for (std::atomic<const void*>& hazard : other.hazards)
+            {
+                if (const void* p = hazard.load(std::memory_order_acquire)) snapshot.push_back(p);
+            }
+        });
+        std::sort(snapshot.begin(), snapshot.end());
+
+        // A deleter may retire more nodes, so free from a separate list
+        std::vector<detail::Retired>& pending = record->pending;
+        pending.clear();
+        std::swap(pending, record->retired);
+        for (detail::Retired& r : pending)
+        {
+            if (std::binary_search(snapshot.begin(), snapshot.end(), static_cast<const void*>(r.object)))
+            {
+                record->retired.push_back(r);
+            }
+            else
+            {
+                r.deleter(r.object);
+            }
+        }
+        pending.clear();
+        record->scanning = false;
+    }
+};
+
+static_assert(Reclaimer<HazardPointers>);
@@ -0,0 +1,114 @@
+/*
+
+Lock-free sorted list
+
+Four threads insert, remove and look up random keys from a small range in the
+same LockFreeList, so most operations collide on the same few nodes, once with
+each reclamation policy. Each thread counts its successful inserts and removes
+per key. With set semantics, a key's inserts minus removes is 1 if it is in the
+list at the end and 0 otherwise; the final list must also be strictly sorted.
+The std::string run uses keys too long for the small-string buffer, so an
+insert that retries after moving its key in would be caught.
+
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "epoch_reclaimer.hpp"
+#include "hazard_pointers.hpp"
+#include "lock_free_list.hpp"
+
+template <typename Key>
+Key key_of(int k);
+
+template <>
+int key_of<int>(int k)
+{
+    return k;
+}
+
+// Zero-padded, so the strings sort like the numbers
+template <>
+std::string key_of<std::string>(int k)
+{
+    char digits[8];
+    std::snprintf(digits, sizeof digits, "%03d", k);
+    return "a-key-long-enough-to-live-on-the-heap-" + std::string(digits);
+}
+
+template <typename Key, typename Reclaimer>
+bool run(const std::string& name)
+{
+    const int threads = 4;
+    const int operations = 200000;
+    const int keys = 64;
+
+    LockFreeList<Key, Reclaimer> list;
+    std::vector<std::vector<std::int64_t>> net(threads, std::vector<std::int64_t>(keys));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]
+        {
+            std::mt19937 rng(t + 1);
+            std::uniform_int_distribution<int> key(0, keys - 1);
+            std::uniform_int_distribution<int> op(0, 2);
+            for (int i = 0; i < operations; ++i)
+            {
+                int k = key(rng);
+                switch (op(rng))
+                {
+                case 0: net[t][k] += list.insert(key_of<Key>(k)); break;
+                case 1: net[t][k] -= list.remove(key_of<Key>(k)); break;
+                default: list.contains(key_of<Key>(k)); break;
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    bool ok = true;
+    int present = 0;
+    for (int k = 0; k < keys; ++k)
+    {
+        std::int64_t sum = 0;
+        for (int t = 0; t < threads; ++t)
+        {
+            sum += net[t][k];
+        }
+        bool contained = list.contains(key_of<Key>(k));
+        ok = ok && sum == (contained ? 1 : 0);
+        present += contained;
+    }
+
+    Key previous{};
+    int listed = 0;
+    list.for_each([&](const Key& k)
+    {
+        ok = ok && (listed == 0 || previous < k);
+        previous = k;
+        ++listed;
+    });
+    ok = ok && listed == present;
+
+    std::cout << name << ": " << present << " keys left, "
+              << (ok ? "inserts and removes consistent, list sorted" : "LIST INCONSISTENT") << "\n";
+    return ok;
+}
+
+int main()
+{
+    bool ok = run<int, HazardPointers>("HazardPointers");
+    ok = run<int, EpochReclaimer>("EpochReclaimer") && ok;
+    ok = run<std::string, HazardPointers>("HazardPointers, std::string keys") && ok;
+    ok = run<std::string, EpochReclaimer>("EpochReclaimer, std::string keys") && ok;
+    return ok ? 0 : 1;
+}
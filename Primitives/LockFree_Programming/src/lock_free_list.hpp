@@ -0,0 +1,120 @@
+/*
+
+Lock-free sorted linked list (set)
+
+LockFreeLinkedList::remove in LockFreeProgramming.md unlinks a node with a
+plain `prev->next = curr->next`: two removers race on the same field, and an
+insert after `curr` that lands meanwhile is silently dropped.
+LockFreeList<Key, Reclaimer, Compare> is a Harris-Michael list
+(ordered_list.hpp) kept sorted by Compare, with set semantics:
+
+insert(key)   : adds the key; false if it is already present.
+remove(key)   : deletes the key; false if it is absent. The node is marked,
+                then unlinked; a traversal that meets a marked node finishes
+                the unlink itself.
+contains(key) : true if the key is present.
+
+All three are lock-free. Unlinked nodes go to the Reclaimer policy
+(reclaimer.hpp), so a thread still walking over them stays safe.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "hazard_pointers.hpp"
+#include "ordered_list.hpp"
+#include "reclaimer.hpp"
+
+template <typename Key, Reclaimer R = HazardPointers, typename Compare = std::less<Key>>
+class LockFreeList
+{
+public:
+    LockFreeList() = default;
+    LockFreeList(const LockFreeList&) = delete;
+    LockFreeList& operator=(const LockFreeList&) = delete;
+
+    ~LockFreeList()
+    {
+        for (Node* node = List::node_of(head.load(std::memory_order_relaxed)); node; )
+        {
+            Node* next = List::node_of(node->next.load(std::memory_order_relaxed));
+            delete node;
+            node = next;
+        }
+    }
+
+    template <typename K>
+    bool insert(K&& key)
+    {
+        typename R::Guard guard;
+        typename List::Position pos;
+        Node* node = nullptr;
+        for (;;)
+        {
+            // key may have been moved into node by an earlier attempt
+            if (List::find(head, node ? order(node->key) : order(key), guard, pos))
+            {
+                delete node;
+                return false;
+            }
+            if (!node) node = new Node{{0}, std::forward<K>(key)};
+            if (List::link(pos, node)) return true;
+        }
+    }
+
+    bool remove(const Key& key)
+    {
+        typename R::Guard guard;
+        typename List::Position pos;
+        for (;;)
+        {
+            if (!List::find(head, order(key), guard, pos)) return false;
+            if (!List::mark(pos)) continue; // Successor changed, or another remove won
+
+            if (!List::unlink(pos)) List::find(head, order(key), guard, pos); // Lets find() unlink it
+            return true;
+        }
+    }
+
+    bool contains(const Key& key)
+    {
+        typename R::Guard guard;
+        typename List::Position pos;
+        return List::find(head, order(key), guard, pos);
+    }
+
+    // Calls f(key) on every key in order; only meaningful while no other thread modifies the list
+    template <typename F>
+    void for_each(F&& f) const
+    {
+        for (Node* node = List::node_of(head.load(std::memory_order_acquire)); node; node = List::node_of(node->next.load(std::memory_order_acquire)))
+        {
+            if (!detail::is_marked(node->next.load(std::memory_order_acquire))) f(node->key);
+        }
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<std::uintptr_t> next;
+        Key key;
+    };
+
+    using List = detail::OrderedList<Node, R>;
+
+    auto order(const Key& key) const
+    {
+        return [this, &key](const Node& node)
+        {
+            if (less(node.key, key)) return -1;
+            return less(key, node.key) ? 1 : 0;
+        };
+    }
+
+    alignas(64) std::atomic<std::uintptr_t> head{0};
+    [[no_unique_address]] Compare less;
+};
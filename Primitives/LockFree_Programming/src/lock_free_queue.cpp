@@ -0,0 +1,176 @@
+/*
+
+Lock-free queue stress test
+
+Producers and consumers hammer a LockFreeQueue that starts with a single chunk
+of nodes, so it also grows and recycles nodes under load. Every operation is
+stamped with a global counter when it starts and when it returns, and the
+history is checked afterwards:
+
+1. Every item is dequeued exactly once.
+2. Items of one producer leave in the order they were enqueued.
+3. FIFO between producers: if enqueue(a) returned before enqueue(b) started,
+   dequeue(b) must not return before dequeue(a) started.
+4. An empty result is only allowed if no item sat in the queue during the
+   whole call (enqueued before it started, dequeued after it returned).
+
+Checks 3 and 4 are the conditions for a FIFO queue history with distinct values
+to be linearizable, and run in O(n log n) with a sweep over sorted stamps.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <vector>
+#include "lock_free_queue.hpp"
+
+namespace
+{
+
+const int producers = 4;
+const int consumers = 4;
+const std::uint32_t per_producer = 100000;
+
+std::atomic<std::uint64_t> clock_ticks{0};
+
+std::uint64_t now() { return clock_ticks.fetch_add(1, std::memory_order_seq_cst); }
+
+struct Interval
+{
+    std::uint64_t start = 0;
+    std::uint64_t end = 0;
+};
+
+struct Item
+{
+    Interval enq;
+    Interval deq;
+    int dequeues = 0;
+};
+
+// True if some item a with a.enq.end < b.enq.start has b.deq.end < a.deq.start
+bool fifo_violated(const std::vector<Item>& items)
+{
+    std::vector<const Item*> by_enq_end, by_enq_start;
+    for (const Item& item : items)
+    {
+        by_enq_end.push_back(&item);
+        by_enq_start.push_back(&item);
+    }
+    std::sort(by_enq_end.begin(), by_enq_end.end(), [](const Item* x, const Item* y) { return x->enq.end < y->enq.end; });
+    std::sort(by_enq_start.begin(), by_enq_start.end(), [](const Item* x, const Item* y) { return x->enq.start < y->enq.start; });
+
+    std::uint64_t latest_deq_start = 0;
+    std::size_t a = 0;
+    for (const Item* b : by_enq_start)
+    {
+        for (; a < by_enq_end.size() && by_enq_end[a]->enq.end < b->enq.start; ++a)
+        {
+            latest_deq_start = std::max(latest_deq_start, by_enq_end[a]->deq.start);
+        }
+        if (b->deq.end < latest_deq_start) return true;
+    }
+    return false;
+}
+
+// True if an empty dequeue overlaps an item that was in the queue for its whole duration
+bool empty_violated(const std::vector<Item>& items, std::vector<Interval> empties)
+{
+    std::vector<const Item*> by_enq_end;
+    for (const Item& item : items)
+    {
+        by_enq_end.push_back(&item);
+    }
+    std::sort(by_enq_end.begin(), by_enq_end.end(), [](const Item* x, const Item* y) { return x->enq.end < y->enq.end; });
+    std::sort(empties.begin(), empties.end(), [](const Interval& x, const Interval& y) { return x.start < y.start; });
+
+    std::uint64_t latest_deq_start = 0;
+    std::size_t a = 0;
+    for (const Interval& empty : empties)
+    {
+        for (; a < by_enq_end.size() && by_enq_end[a]->enq.end < empty.start; ++a)
+        {
+            latest_deq_start = std::max(latest_deq_start, by_enq_end[a]->deq.start);
+        }
+        if (latest_deq_start > empty.end) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main()
+{
+    LockFreeQueue<std::uint64_t> queue(1);
+    std::vector<Item> items(producers * per_producer);
+    std::vector<std::vector<Interval>> empties(consumers);
+    std::atomic<std::uint32_t> remaining{producers * per_producer};
+    std::atomic<bool> order_ok{true};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]
+        {
+            for (std::uint32_t seq = 0; seq < per_producer; ++seq)
+            {
+                Item& item = items[p * per_producer + seq];
+                item.enq.start = now();
+                queue.enqueue((std::uint64_t(p) << 32) | seq);
+                item.enq.end = now();
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c)
+    {
+        threads.emplace_back([&, c]
+        {
+            std::vector<std::int64_t> last_seq(producers, -1);
+            while (remaining.load(std::memory_order_relaxed) > 0)
+            {
+                std::uint64_t start = now();
+                std::optional<std::uint64_t> value = queue.dequeue();
+                std::uint64_t end = now();
+                if (!value)
+                {
+                    empties[c].push_back({start, end});
+                    continue;
+                }
+
+                int p = static_cast<int>(*value >> 32);
+                std::uint32_t seq = static_cast<std::uint32_t>(*value);
+                Item& item = items[p * per_producer + seq];
+                item.deq = {start, end};
+                ++item.dequeues;
+                if (static_cast<std::int64_t>(seq) <= last_seq[p]) order_ok.store(false);
+                last_seq[p] = seq;
+                remaining.fetch_sub(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    bool once = std::all_of(items.begin(), items.end(), [](const Item& item) { return item.dequeues == 1; });
+    std::vector<Interval> all_empties;
+    for (const std::vector<Interval>& list : empties)
+    {
+        all_empties.insert(all_empties.end(), list.begin(), list.end());
+    }
+    bool fifo = !fifo_violated(items);
+    bool empty = !empty_violated(items, all_empties);
+
+    std::cout << items.size() << " items, " << all_empties.size() << " empty dequeues, "
+              << queue.capacity() << " nodes allocated\n"
+              << "every item dequeued once : " << (once ? "yes" : "NO") << "\n"
+              << "per-producer order kept  : " << (order_ok.load() ? "yes" : "NO") << "\n"
+              << "FIFO across producers    : " << (fifo ? "yes" : "NO") << "\n"
+              << "empty results consistent : " << (empty ? "yes" : "NO") << "\n";
+    return once && order_ok.load() && fifo && empty && queue.empty() ? 0 : 1;
+}
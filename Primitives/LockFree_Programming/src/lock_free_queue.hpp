@@ -0,0 +1,266 @@
+/*
+
+Michael-Scott lock-free queue with index + generation tags
+
+The LockFreeQueue of LockFreeProgramming.md swings `tail` with a CAS and only
+then links the old tail with a plain store, so a dequeuer can see `tail` ahead
+of the list and items are lost or reordered. This is the algorithm of Michael &
+Scott (1996) with its counted pointers:
+
+- The list always starts with a dummy node. enqueue CASes the last node's
+  `next` from null to the new node, then swings `tail` (any thread that finds
+  `tail` lagging helps it forward first). dequeue swings `head` to the first
+  real node, which becomes the new dummy, and takes the value out of it.
+- Every link (`head`, `tail`, each `next`) is a 64-bit word holding a 32-bit node
+  index and a 32-bit generation that grows with every CAS on that word. A CAS
+  that read a link before the node was dequeued, recycled and enqueued again
+  fails because the generation moved on: no ABA, with a plain 64-bit CAS
+  instead of a double-width one.
+- Nodes are never returned to the allocator while the queue exists. A dequeued
+  node goes on a free list (a Treiber stack of indices, tagged the same way) and
+  is reused by the next enqueue, so a thread holding a stale index only ever
+  reads a live node's links, and its CAS then fails.
+- Nodes live in chunks of 1024, 2048, 4096, ... nodes that are never moved, so
+  an index maps to its node with a bit scan. When the free list runs dry a new
+  chunk is added under a mutex, the only lock in the queue.
+
+A node is recycled once two things have happened: it has been unlinked as the
+old dummy, and the dequeuer that made it the dummy has moved its value out.
+Whichever of the two comes last puts it on the free list.
+
+dequeue() returns std::nullopt when the queue is empty.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+template <typename T>
+class LockFreeQueue
+{
+public:
+    explicit LockFreeQueue(std::size_t reserve = first_chunk)
+    {
+        while (capacity() < reserve + 1)
+        {
+            add_chunk();
+        }
+
+        std::uint32_t dummy = allocate();
+        node(dummy).holders.store(1, std::memory_order_relaxed); // No value to take
+        head.store(tag(dummy, 0), std::memory_order_relaxed);
+        tail.store(tag(dummy, 0), std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    ~LockFreeQueue()
+    {
+        std::uint32_t dummy = index_of(head.load(std::memory_order_relaxed));
+        for (std::uint32_t i = index_of(node(dummy).next.load(std::memory_order_relaxed)); i != null; )
+        {
+            Node& n = node(i);
+            std::destroy_at(n.item());
+            i = index_of(n.next.load(std::memory_order_relaxed));
+        }
+        for (std::size_t k = 0; k < chunk_count.load(std::memory_order_relaxed); ++k)
+        {
+            delete[] chunks[k].load(std::memory_order_relaxed);
+        }
+    }
+
+    template <typename U>
+    void enqueue(U&& value)
+    {
+        std::uint32_t i = allocate();
+        Node& n = node(i);
+        try
+        {
+            std::construct_at(n.item(), std::forward<U>(value));
+        }
+        catch (...)
+        {
+            push_free(i, i);
+            throw;
+        }
+        n.holders.store(2, std::memory_order_relaxed);
+        std::uint64_t old_next = n.next.load(std::memory_order_relaxed);
+        n.next.store(tag(null, generation_of(old_next) + 1), std::memory_order_relaxed);
+
+        std::uint64_t last;
+        for (;;)
+        {
+            last = tail.load(std::memory_order_acquire);
+            std::uint64_t next = node(index_of(last)).next.load(std::memory_order_acquire);
+            if (last != tail.load(std::memory_order_acquire)) continue;
+
+            if (index_of(next) == null)
+            {
+                // Publishes the value: pairs with the acquire loads of `next` in dequeue
+                if (node(index_of(last)).next.compare_exchange_weak(next, tag(i, generation_of(next) + 1), std::memory_order_release, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                advance(tail, last, index_of(next)); // Help a lagging tail
+            }
+        }
+        advance(tail, last, i);
+    }
+
+    std::optional<T> dequeue()
+    {
+        for (;;)
+        {
+            std::uint64_t first = head.load(std::memory_order_acquire);
+            std::uint64_t last = tail.load(std::memory_order_acquire);
+            std::uint64_t next = node(index_of(first)).next.load(std::memory_order_acquire);
+            if (first != head.load(std::memory_order_acquire)) continue;
+
+            if (index_of(first) == index_of(last))
+            {
+                if (index_of(next) == null) return std::nullopt;
+                advance(tail, last, index_of(next)); // Help a lagging tail
+                continue;
+            }
+
+            if (head.compare_exchange_weak(first, tag(index_of(next), generation_of(first) + 1), std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                // `next` is the new dummy; only this thread may take its value
+                Node& taken = node(index_of(next));
+                std::optional<T> value(std::move(*taken.item()));
+                std::destroy_at(taken.item());
+                release(index_of(next));
+                release(index_of(first));
+                return value;
+            }
+        }
+    }
+
+    bool empty() const
+    {
+        std::uint64_t first = head.load(std::memory_order_acquire);
+        return index_of(node(index_of(first)).next.load(std::memory_order_acquire)) == null;
+    }
+
+    // Nodes allocated so far, in use or on the free list
+    std::size_t capacity() const
+    {
+        return first_chunk * ((std::size_t(1) << chunk_count.load(std::memory_order_acquire)) - 1);
+    }
+
+private:
+    static constexpr std::size_t first_chunk = 1024;
+    static constexpr std::size_t max_chunks = 22; // 1024 * (2^22 - 1) indices fit below `null`
+    static constexpr std::uint32_t null = 0xffffffff;
+
+    struct Node
+    {
+        std::atomic<std::uint64_t> next{tag(null, 0)};
+        std::atomic<std::uint32_t> free_next{null};
+        std::atomic<std::uint32_t> holders{0}; // Unlink and value hand-over still to come
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return reinterpret_cast<T*>(storage); }
+    };
+
+    static constexpr std::uint64_t tag(std::uint32_t index, std::uint32_t generation)
+    {
+        return (std::uint64_t(generation) << 32) | index;
+    }
+
+    static constexpr std::uint32_t index_of(std::uint64_t link) { return static_cast<std::uint32_t>(link); }
+    static constexpr std::uint32_t generation_of(std::uint64_t link) { return static_cast<std::uint32_t>(link >> 32); }
+
+    // Chunk k holds first_chunk << k nodes, starting at index first_chunk * (2^k - 1)
+    Node& node(std::uint32_t index) const
+    {
+        std::size_t slot = index / first_chunk + 1;
+        std::size_t k = static_cast<std::size_t>(std::bit_width(slot)) - 1;
+        std::size_t offset = index - first_chunk * ((std::size_t(1) << k) - 1);
+        return chunks[k].load(std::memory_order_acquire)[offset];
+    }
+
+    void advance(std::atomic<std::uint64_t>& link, std::uint64_t expected, std::uint32_t index)
+    {
+        link.compare_exchange_strong(expected, tag(index, generation_of(expected) + 1), std::memory_order_release, std::memory_order_relaxed);
+    }
+
+    void release(std::uint32_t index)
+    {
+        if (node(index).holders.fetch_sub(1, std::memory_order_acq_rel) == 1) push_free(index, index);
+    }
+
+    std::uint32_t allocate()
+    {
+        for (;;)
+        {
+            std::uint64_t top = free_top.load(std::memory_order_acquire);
+            if (index_of(top) == null)
+            {
+                grow(top);
+                continue;
+            }
+            std::uint32_t next = node(index_of(top)).free_next.load(std::memory_order_relaxed);
+            if (free_top.compare_exchange_weak(top, tag(next, generation_of(top) + 1), std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return index_of(top);
+            }
+        }
+    }
+
+    // Pushes the chain first -> ... -> last, already linked through free_next
+    void push_free(std::uint32_t first, std::uint32_t last)
+    {
+        std::uint64_t top = free_top.load(std::memory_order_relaxed);
+        do
+        {
+            node(last).free_next.store(index_of(top), std::memory_order_relaxed);
+        } while (!free_top.compare_exchange_weak(top, tag(first, generation_of(top) + 1), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Adds a chunk unless another thread refilled the free list since `seen` was read
+    void grow(std::uint64_t seen)
+    {
+        std::lock_guard<std::mutex> lock(grow_mtx);
+        if (free_top.load(std::memory_order_acquire) != seen) return;
+        add_chunk();
+    }
+
+    void add_chunk()
+    {
+        std::size_t k = chunk_count.load(std::memory_order_relaxed);
+        if (k == max_chunks) throw std::length_error("LockFreeQueue: too many nodes");
+
+        std::size_t size = first_chunk << k;
+        std::uint32_t base = static_cast<std::uint32_t>(first_chunk * ((std::size_t(1) << k) - 1));
+        Node* nodes = new Node[size];
+        for (std::size_t i = 0; i + 1 < size; ++i)
+        {
+            nodes[i].free_next.store(base + static_cast<std::uint32_t>(i) + 1, std::memory_order_relaxed);
+        }
+        chunks[k].store(nodes, std::memory_order_release);
+        chunk_count.store(k + 1, std::memory_order_release);
+        push_free(base, base + static_cast<std::uint32_t>(size) - 1);
+    }
+
+    alignas(64) std::atomic<std::uint64_t> head{tag(null, 0)};
+    alignas(64) std::atomic<std::uint64_t> tail{tag(null, 0)};
+    alignas(64) std::atomic<std::uint64_t> free_top{tag(null, 0)};
+
+    std::atomic<Node*> chunks[max_chunks] = {};
+    std::atomic<std::size_t> chunk_count{0};
+    std::mutex grow_mtx;
+};
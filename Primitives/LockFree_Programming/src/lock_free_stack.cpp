@@ -0,0 +1,78 @@
+/*
+
+Lock-free stack
+
+Four threads push and pop the same LockFreeStack concurrently, once with each
+reclamation policy. Every thread pushes its own range of numbers and pops as
+many items as it pushed; at the end every number must have been popped exactly
+once. The program also prints whether the head of the stack in
+LockFreeProgramming.md, a std::atomic<std::shared_ptr>, is lock-free.
+
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "epoch_reclaimer.hpp"
+#include "hazard_pointers.hpp"
+#include "lock_free_stack.hpp"
+
+template <typename Reclaimer>
+bool run(const std::string& name)
+{
+    const int threads = 4;
+    const int per_thread = 200000;
+
+    LockFreeStack<int, Reclaimer> stack;
+    std::vector<std::atomic<int>> seen(threads * per_thread);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]
+        {
+            for (int i = 0; i < per_thread; ++i)
+            {
+                stack.push(t * per_thread + i);
+                if (i % 2 == 1) // Pop two for every two pushed, keeping the stack short and busy
+                {
+                    for (int k = 0; k < 2; ++k)
+                    {
+                        std::optional<int> value;
+                        while (!(value = stack.pop()))
+                        {
+                        }
+                        seen[*value].fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    bool ok = stack.empty();
+    for (std::atomic<int>& count : seen)
+    {
+        ok = ok && count.load() == 1;
+    }
+    std::cout << name << ": " << (ok ? "every item popped exactly once" : "ITEMS LOST OR DUPLICATED") << "\n";
+    return ok;
+}
+
+int main()
+{
+    struct Node;
+    std::cout << "std::atomic<std::shared_ptr<Node>> is lock-free: " << std::boolalpha
+              << std::atomic<std::shared_ptr<Node>>().is_lock_free() << "\n"
+              << "std::atomic<Node*> is lock-free: " << std::atomic<Node*>().is_lock_free() << "\n";
+
+    bool ok = run<HazardPointers>("HazardPointers");
+    ok = run<EpochReclaimer>("EpochReclaimer") && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+
+Lock-free stack (Treiber) on raw pointers
+
+The LockFreeStack of LockFreeProgramming.md keeps its head in a
+std::atomic<std::shared_ptr<Node>>. On libstdc++ that type is not lock-free
+(is_lock_free() is false: every load and CAS takes an internal spin lock), and
+each load copies the shared_ptr, so every push and pop writes the reference
+count of the top node from every thread.
+
+LockFreeStack<T, Reclaimer> keeps a plain std::atomic<Node*>: push and pop are
+one CAS on `head` each, with no reference counting. A popped node is handed to
+the Reclaimer policy (reclaimer.hpp) instead of being deleted, so a thread that
+still reads its `next` field in a concurrent pop is safe. The same protection
+rules out ABA: a node cannot be freed and reallocated at the same address while
+a popping thread holds it.
+
+Under contention every thread retries its CAS against the same cache line.
+With EliminationSlots > 0 (the default is 16), an operation whose CAS on `head`
+fails first tries to meet an operation of the opposite kind in an
+EliminationArray (elimination_array.hpp): a push hands its node straight to a
+pop and neither touches `head`. Balanced push/pop loads gain the most; with
+EliminationSlots = 0 the stack is a plain Treiber stack.
+
+pop() returns std::nullopt when the stack is empty.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include "elimination_array.hpp"
+#include "hazard_pointers.hpp"
+#include "reclaimer.hpp"
+
+template <typename T, Reclaimer R = HazardPointers, std::size_t EliminationSlots = 16>
+class LockFreeStack
+{
+public:
+    LockFreeStack() = default;
+    LockFreeStack(const LockFreeStack&) = delete;
+    LockFreeStack& operator=(const LockFreeStack&) = delete;
+
+    ~LockFreeStack()
+    {
+        for (Node* node = head.load(std::memory_order_relaxed); node; )
+        {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    template <typename U>
+    void push(U&& value)
+    {
+        Node* node = new Node{std::forward<U>(value), head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+        {
+            if constexpr (EliminationSlots > 0)
+            {
+                elimination.on_cas_failure();
+                if (elimination.offer(node)) return; // A pop took it
+            }
+        }
+    }
+
+    std::optional<T> pop()
+    {
+        typename R::Guard guard;
+        Node* top = guard.protect(0, head);
+        while (top)
+        {
+            if (head.compare_exchange_weak(top, top->next, std::memory_order_acquire, std::memory_order_relaxed)) break;
+
+            if constexpr (EliminationSlots > 0)
+            {
+                elimination.on_cas_failure();
+                if (Node* node = elimination.take())
+                {
+                    // Handed over by a push, never in the stack: nobody else can reach it
+                    std::optional<T> value(std::move(node->value));
+                    delete node;
+                    return value;
+                }
+            }
+            top = guard.protect(0, head);
+        }
+        if (!top) return std::nullopt;
+
+        std::optional<T> value(std::move(top->value)); // Other threads may still read top->next, never the value
+        guard.reset(0);
+        R::retire(top);
+        return value;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node
+    {
+        T value;
+        Node* next;
+    };
+
+    alignas(64) std::atomic<Node*> head{nullptr};
+    EliminationArray<Node, (EliminationSlots > 0 ? EliminationSlots : 1)> elimination; // Unused when EliminationSlots is 0
+};
@@ -0,0 +1,135 @@
+/*
+
+Harris-Michael lock-free ordered list: the algorithm
+
+Shared by LockFreeList (lock_free_list.hpp) and the buckets of SplitOrderedMap.
+A node is removed in two steps (Harris, 2001):
+
+1. Logical deletion: the low bit of the node's own `next` link is set with a
+   CAS. From then on nothing can be linked after the node, and every thread
+   treats it as gone.
+2. Physical deletion: the predecessor's link is swung past the node with a CAS,
+   and the node is handed to the Reclaimer.
+
+find() walks the list and finishes step 2 for every marked node it meets
+(helping), so a remover that loses the race for step 2 can simply leave it.
+Following Michael (2002), find() re-checks the predecessor's link after
+protecting each node and restarts from the beginning when it changed; with
+hazard pointers it uses three slots: 0 for `next`, 1 for `curr` and 2 for the
+node that owns `prev`.
+
+Nodes need a `std::atomic<std::uintptr_t> next` member; the walk is steered by
+an `order(node)` function that returns < 0 while the node sorts before the
+key, 0 on a match and > 0 past it.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "reclaimer.hpp"
+
+namespace detail
+{
+
+inline bool is_marked(std::uintptr_t link) { return (link & 1) != 0; }
+inline std::uintptr_t unmarked(std::uintptr_t link) { return link & ~std::uintptr_t(1); }
+
+// For Guard::protect: the node a link points to, without the mark
+struct StripMark
+{
+    const void* operator()(std::uintptr_t link) const { return reinterpret_cast<const void*>(unmarked(link)); }
+};
+
+template <typename Node, Reclaimer R>
+struct OrderedList
+{
+    using Guard = typename R::Guard;
+
+    // Where a key belongs: *prev links to curr, whose successor was `next` (unmarked)
+    struct Position
+    {
+        std::atomic<std::uintptr_t>* prev = nullptr;
+        Node* curr = nullptr;
+        std::uintptr_t next = 0;
+    };
+
+    static std::uintptr_t link_of(Node* node) { return reinterpret_cast<std::uintptr_t>(node); }
+    static Node* node_of(std::uintptr_t link) { return reinterpret_cast<Node*>(unmarked(link)); }
+
+    // Finds the first node with order(node) >= 0 after `start`, which must stay linked
+    // (the list head or a node that is never removed). True on an exact match.
+    template <typename Order>
+    static bool find(std::atomic<std::uintptr_t>& start, Order order, Guard& guard, Position& pos)
+    {
+    retry:
+        std::atomic<std::uintptr_t>* prev = &start;
+        std::uintptr_t curr_link = guard.protect(1, *prev, StripMark{});
+        for (;;)
+        {
+            Node* curr = node_of(curr_link);
+            if (!curr)
+            {
+                pos = {prev, nullptr, 0};
+                return false;
+            }
+
+            std::uintptr_t next = guard.protect(0, curr->next, StripMark{});
+            if (prev->load(std::memory_order_acquire) != link_of(curr)) goto retry; // prev changed or got marked
+
+            if (!is_marked(next))
+            {
+                int c = order(*curr);
+                if (c >= 0)
+                {
+                    pos = {prev, curr, next};
+                    return c == 0;
+                }
+                prev = &curr->next;
+                guard.set(2, curr);
+            }
+            else
+            {
+                // curr is logically deleted: unlink it on its remover's behalf
+                std::uintptr_t expected = link_of(curr);
+                if (!prev->compare_exchange_strong(expected, unmarked(next), std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    goto retry;
+                }
+                R::retire(curr);
+            }
+            curr_link = unmarked(next);
+            guard.set(1, node_of(curr_link));
+        }
+    }
+
+    // Links `node` in front of pos.curr; false if the list changed there
+    static bool link(const Position& pos, Node* node)
+    {
+        node->next.store(link_of(pos.curr), std::memory_order_relaxed);
+        std::uintptr_t expected = link_of(pos.curr);
+        return pos.prev->compare_exchange_strong(expected, link_of(node), std::memory_order_release, std::memory_order_relaxed);
+    }
+
+    // Logically deletes pos.curr; false if its successor changed or another thread deleted it first
+    static bool mark(const Position& pos)
+    {
+        std::uintptr_t expected = pos.next;
+        return pos.curr->next.compare_exchange_strong(expected, pos.next | 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+
+    // Unlinks a node marked by mark(pos); false if the list changed there (a later find() will do it)
+    static bool unlink(const Position& pos)
+    {
+        std::uintptr_t expected = link_of(pos.curr);
+        if (!pos.prev->compare_exchange_strong(expected, pos.next, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            return false;
+        }
+        R::retire(pos.curr);
+        return true;
+    }
+};
+
+} // namespace detail
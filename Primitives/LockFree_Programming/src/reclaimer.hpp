@@ -0,0 +1,134 @@
+/*
+
+Safe memory reclamation for lock-free data structures
+
+A thread that unlinks a node from a lock-free structure cannot delete it right
+away: other threads may have loaded a pointer to it and be about to read it.
+std::atomic<std::shared_ptr> solves this with reference counts, but on
+libstdc++ every load and store of it takes an internal spin lock and every copy
+bounces the count's cache line between cores. A Reclaimer policy lets the
+structure work on raw pointers instead:
+
+- An operation opens a Guard. While the guard is alive, a pointer obtained with
+  guard.protect(slot, src) may be dereferenced, even if another thread unlinks
+  the node meanwhile.
+- guard.set(slot, p) moves protection to a pointer that is already protected by
+  another slot of the same guard (walking a list hand over hand); guard.reset
+  drops a slot.
+- Reclaimer::retire(p) hands an unlinked node over; it is deleted once no guard
+  can reach it any more. retire(p, deleter) calls deleter(p) instead of delete.
+- Guards nest, within one structure or across several, as long as the
+  innermost is destroyed first (HazardPointers allows max_depth of them).
+
+Two policies meet the Reclaimer concept:
+
+HazardPointers (hazard_pointers.hpp) : every protected pointer is published in a
+                                       per-thread slot; a retired node is freed
+                                       once no slot holds it. Memory waiting for
+                                       reclamation is bounded, even with a
+                                       stalled thread, at the price of a fence
+                                       per protect.
+EpochReclaimer (epoch_reclaimer.hpp) : a guard announces the global epoch; a
+                                       node retired in epoch e is freed once
+                                       every active guard has seen epoch e + 2.
+                                       protect is a plain load, but a thread
+                                       stuck inside a guard holds back all
+                                       reclamation.
+
+Both keep one record per thread, in a list that only grows; a thread takes a
+free record on first use and gives it back when it exits, together with any
+nodes it retired that could not be freed yet.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+
+template <typename R>
+concept Reclaimer = std::default_initializable<typename R::Guard> &&
+    requires(typename R::Guard& guard, const std::atomic<int*>& src, int* p, void (*deleter)(void*))
+{
+    { guard.protect(0, src) } -> std::same_as<int*>;
+    guard.set(0, p);
+    guard.reset(0);
+    R::retire(p);
+    R::retire(static_cast<void*>(p), deleter);
+};
+
+namespace detail
+{
+
+// Converts what an atomic holds to the node address to protect (e.g. strips mark bits)
+struct Unmarked
+{
+    template <typename P>
+    const void* operator()(P p) const { return p; }
+};
+
+// Per-thread records of a reclamation domain. Records are only freed with the domain.
+template <typename Record>
+class RecordList
+{
+public:
+    RecordList() = default;
+    RecordList(const RecordList&) = delete;
+    RecordList& operator=(const RecordList&) = delete;
+
+    ~RecordList()
+    {
+        for (Record* record = head.load(std::memory_order_acquire); record; )
+        {
+            Record* next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    Record* acquire()
+    {
+        for (Record* record = head.load(std::memory_order_acquire); record; record = record->next)
+        {
+            if (!record->in_use.load(std::memory_order_relaxed) && !record->in_use.exchange(true, std::memory_order_acquire))
+            {
+                return record;
+            }
+        }
+
+        Record* record = new Record;
+        record->in_use.store(true, std::memory_order_relaxed);
+        record->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    void release(Record* record) { record->in_use.store(false, std::memory_order_release); }
+
+    template <typename F>
+    void for_each(F&& f)
+    {
+        for (Record* record = head.load(std::memory_order_acquire); record; record = record->next)
+        {
+            f(*record);
+        }
+    }
+
+    std::size_t size() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<Record*> head{nullptr};
+    std::atomic<std::size_t> count{0};
+};
+
+struct Retired
+{
+    void* object;
+    void (*deleter)(void*);
+};
+
+} // namespace detail
@@ -0,0 +1,140 @@
+/*
+
+Split-ordered hash map
+
+Runs with each reclamation policy, starting from a map with a single bucket:
+
+1. Growth: four threads insert their own range of keys while the table grows
+   under them. Afterwards every key must be found with its value, and size()
+   must match.
+2. Contention: four threads insert, insert_or_assign, erase and find random
+   keys from a small range. A value always encodes its key, so every hit must
+   carry its own key. Per key, successful inserts (both kinds) minus erases
+   must be 1 if the key is left in the map and 0 otherwise.
+3. Shrink: every key is erased again; the map must end up empty.
+
+*/
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "epoch_reclaimer.hpp"
+#include "hazard_pointers.hpp"
+#include "split_ordered_map.hpp"
+
+namespace
+{
+
+const int threads = 4;
+const std::uint64_t per_thread = 50000;
+const int contended_keys = 64;
+const int operations = 200000;
+
+template <typename F>
+void in_parallel(F f)
+{
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back(f, t);
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+} // namespace
+
+template <typename Reclaimer>
+bool run(const std::string& name)
+{
+    using Map = SplitOrderedMap<std::uint64_t, std::uint64_t, Reclaimer>;
+    Map map;
+    const std::uint64_t total = threads * per_thread;
+
+    // 1. Growth
+    in_parallel([&](int t)
+    {
+        for (std::uint64_t i = 0; i < per_thread; ++i)
+        {
+            std::uint64_t key = t * per_thread + i;
+            map.insert(key, key * 3);
+        }
+    });
+    bool grown = map.size() == total;
+    for (std::uint64_t key = 0; key < total; ++key)
+    {
+        typename Map::Reference ref = map.find(key);
+        typename Map::Reference next = map.find((key + 1) % total); // Open alongside `ref`
+        grown = grown && ref && ref.key() == key && *ref == key * 3 && next && *next == (key + 1) % total * 3;
+    }
+    std::size_t buckets = map.bucket_count();
+
+    // 2. Contention, on keys above the ones inserted so far
+    std::vector<std::vector<std::int64_t>> net(threads, std::vector<std::int64_t>(contended_keys));
+    std::vector<int> mismatches(threads);
+    in_parallel([&](int t)
+    {
+        std::mt19937 rng(t + 1);
+        std::uniform_int_distribution<int> pick(0, contended_keys - 1);
+        std::uniform_int_distribution<int> op(0, 3);
+        for (int i = 0; i < operations; ++i)
+        {
+            int k = pick(rng);
+            std::uint64_t key = total + k;
+            std::uint64_t value = (key << 16) | static_cast<std::uint64_t>(i & 0xffff);
+            switch (op(rng))
+            {
+            case 0: net[t][k] += map.insert(key, value); break;
+            case 1: net[t][k] += map.insert_or_assign(key, value); break;
+            case 2: net[t][k] -= map.erase(key); break;
+            default:
+                if (typename Map::Reference ref = map.find(key); ref && (*ref >> 16 != key || ref.key() != key)) ++mismatches[t];
+                break;
+            }
+        }
+    });
+    bool contended = true;
+    for (int k = 0; k < contended_keys; ++k)
+    {
+        std::int64_t sum = 0;
+        for (int t = 0; t < threads; ++t)
+        {
+            sum += net[t][k];
+            contended = contended && mismatches[t] == 0;
+        }
+        contended = contended && sum == (map.contains(total + k) ? 1 : 0);
+    }
+
+    // 3. Shrink
+    in_parallel([&](int t)
+    {
+        for (std::uint64_t i = 0; i < per_thread; ++i)
+        {
+            map.erase(t * per_thread + i);
+        }
+    });
+    for (int k = 0; k < contended_keys; ++k)
+    {
+        map.erase(total + k);
+    }
+    bool emptied = map.size() == 0 && !map.contains(0);
+
+    bool ok = grown && contended && emptied;
+    std::cout << name << ": grew from 1 to " << buckets << " buckets for " << total << " keys\n"
+              << "  every key found with its value  : " << (grown ? "yes" : "NO") << "\n"
+              << "  contended updates consistent    : " << (contended ? "yes" : "NO") << "\n"
+              << "  empty after erasing every key   : " << (emptied ? "yes" : "NO") << "\n";
+    return ok;
+}
+
+int main()
+{
+    bool ok = run<HazardPointers>("HazardPointers");
+    ok = run<EpochReclaimer>("EpochReclaimer") && ok;
+    return ok ? 0 : 1;
+}
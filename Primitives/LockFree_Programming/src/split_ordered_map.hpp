@@ -0,0 +1,314 @@
+/*
+
+Resizable lock-free hash map with split-ordered lists (Shalev & Shavit, 2006)
+
+LockFreeHashTable in LockFreeProgramming.md has a fixed number of buckets, so
+chains grow without bound as keys are added. Its insert prepends duplicates
+instead of updating, and lookup allocates a copy of the value on every hit.
+SplitOrderedMap<K, V, Reclaimer, Hash, KeyEqual> keeps every item in one
+Harris-Michael list (ordered_list.hpp) and never moves an item when it grows:
+
+- Items are sorted by their hash with the bits reversed (the split order).
+  With 2^n buckets, the items of bucket b are then contiguous, and bucket b
+  splits into buckets b and b + 2^n exactly where b + 2^n's items begin.
+- Each bucket starts with a sentinel node in the list. The bucket table only
+  holds pointers to sentinels. A sentinel is added the first time an insert
+  reaches its bucket, right after the sentinel of its parent bucket (b with
+  its top bit cleared), and is never removed.
+- Growing is one CAS doubling the bucket count, done by the insert that pushes
+  the load factor above max_load. The new buckets fill in one at a time as
+  inserts reach them: no rehash, no stop-the-world pause.
+- The table is an array of segments of 64, 64, 128, 256, ... bucket pointers,
+  allocated on first use with a CAS, so it never moves either.
+
+insert(key, value)           : adds the item; false if the key is present.
+insert_or_assign(key, value) : adds the item or replaces its value; true if
+                               it was added.
+erase(key)                   : removes the item; false if absent.
+find(key)                    : a Reference to the item, or an empty one.
+                               find() and erase() do not allocate: on a
+                               bucket that has no sentinel yet they start
+                               from its nearest ancestor's.
+
+A value is a separate object that insert_or_assign swaps with one exchange and
+hands to the Reclaimer, so readers never see it change under them. A Reference
+holds the Guard that keeps its item and value alive, so a thread can hold a few
+of them while it keeps using the map (HazardPointers::max_depth guards at once,
+counting the one each operation opens).
+
+The bucket count does not shrink when keys are erased, but erased items are
+freed. After a peak the table keeps one sentinel per bucket it used.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include "hazard_pointers.hpp"
+#include "ordered_list.hpp"
+#include "reclaimer.hpp"
+
+template <typename K, typename V, Reclaimer R = HazardPointers, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class SplitOrderedMap
+{
+    struct Node;
+    using List = detail::OrderedList<Node, R>;
+
+public:
+    static constexpr std::size_t max_load = 2; // Items per bucket before the table doubles
+
+    // An item pinned by a guard; must not outlive the map
+    class Reference
+    {
+    public:
+        Reference(const Reference&) = delete;
+        Reference& operator=(const Reference&) = delete;
+
+        explicit operator bool() const { return value != nullptr; }
+        const K& key() const { return *node->key; }
+        const V& operator*() const { return *value; }
+        const V* operator->() const { return value; }
+
+    private:
+        friend class SplitOrderedMap;
+
+        Reference(SplitOrderedMap& map, const K& key)
+        {
+            typename List::Position pos;
+            if (map.locate(key, guard, pos, false))
+            {
+                node = pos.curr;
+                value = guard.protect(3, pos.curr->value);
+            }
+        }
+
+        typename R::Guard guard;
+        const Node* node = nullptr;
+        const V* value = nullptr;
+    };
+
+    // `buckets` is rounded up to a power of two
+    explicit SplitOrderedMap(std::size_t buckets = 1)
+    {
+        bucket_mask.store(std::bit_ceil(std::max<std::size_t>(buckets, 1)) - 1, std::memory_order_relaxed);
+        bucket(0).store(new Node(0), std::memory_order_relaxed);
+    }
+
+    SplitOrderedMap(const SplitOrderedMap&) = delete;
+    SplitOrderedMap& operator=(const SplitOrderedMap&) = delete;
+
+    ~SplitOrderedMap()
+    {
+        for (Node* node = bucket(0).load(std::memory_order_relaxed); node; )
+        {
+            Node* next = List::node_of(node->next.load(std::memory_order_relaxed));
+            delete node;
+            node = next;
+        }
+        for (std::atomic<std::atomic<Node*>*>& segment : segments)
+        {
+            delete[] segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    template <typename U>
+    bool insert(const K& key, U&& value)
+    {
+        typename R::Guard guard;
+        typename List::Position pos;
+        Node* node = nullptr;
+        for (;;)
+        {
+            if (locate(key, guard, pos, true))
+            {
+                delete node;
+                return false;
+            }
+            if (!node) node = new Node(so_item(hash(key)), key, new V(std::forward<U>(value)));
+            if (List::link(pos, node)) break;
+        }
+        grow_if_loaded();
+        return true;
+    }
+
+    template <typename U>
+    bool insert_or_assign(const K& key, U&& value)
+    {
+        typename R::Guard guard;
+        typename List::Position pos;
+        Node* node = nullptr;
+        for (;;)
+        {
+            if (locate(key, guard, pos, true))
+            {
+                V* fresh = node ? node->value.exchange(nullptr, std::memory_order_relaxed) : new V(std::forward<U>(value));
+                delete node;
+                R::retire(pos.curr->value.exchange(fresh, std::memory_order_acq_rel));
+                return false;
+            }
+            if (!node) node = new Node(so_item(hash(key)), key, new V(std::forward<U>(value)));
+            if (List::link(pos, node)) break;
+        }
+        grow_if_loaded();
+        return true;
+    }
+
+    bool erase(const K& key)
+    {
+        typename R::Guard guard;
+        typename List::Position pos;
+        for (;;)
+        {
+            if (!locate(key, guard, pos, false)) return false;
+            if (!List::mark(pos)) continue; // Successor changed, or another erase won
+
+            if (!List::unlink(pos)) locate(key, guard, pos, false); // Lets find() unlink it
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    Reference find(const K& key) { return Reference(*this, key); }
+
+    bool contains(const K& key) { return static_cast<bool>(find(key)); }
+
+    // Exact when no other thread modifies the map
+    std::size_t size() const { return static_cast<std::size_t>(std::max<std::int64_t>(count.load(std::memory_order_relaxed), 0)); }
+
+    std::size_t bucket_count() const { return bucket_mask.load(std::memory_order_relaxed) + 1; }
+
+private:
+    static constexpr std::size_t first_segment = 64;
+    static constexpr std::size_t max_segments = 32;
+    static constexpr std::size_t max_buckets = first_segment << (max_segments - 1);
+
+    struct Node
+    {
+        std::atomic<std::uintptr_t> next{0};
+        const std::uint64_t so_key;   // Split-order key: odd for items, even for sentinels
+        const std::optional<K> key;   // Empty in sentinels
+        std::atomic<V*> value{nullptr};
+
+        explicit Node(std::uint64_t so) : so_key(so) {}
+        Node(std::uint64_t so, const K& k, V* v) : so_key(so), key(k), value(v) {}
+        ~Node() { delete value.load(std::memory_order_relaxed); }
+    };
+
+    static std::uint64_t reverse_bits(std::uint64_t x)
+    {
+        x = ((x >> 1) & 0x5555555555555555) | ((x & 0x5555555555555555) << 1);
+        x = ((x >> 2) & 0x3333333333333333) | ((x & 0x3333333333333333) << 2);
+        x = ((x >> 4) & 0x0f0f0f0f0f0f0f0f) | ((x & 0x0f0f0f0f0f0f0f0f) << 4);
+        x = ((x >> 8) & 0x00ff00ff00ff00ff) | ((x & 0x00ff00ff00ff00ff) << 8);
+        x = ((x >> 16) & 0x0000ffff0000ffff) | ((x & 0x0000ffff0000ffff) << 16);
+        return (x >> 32) | (x << 32);
+    }
+
+    static std::uint64_t so_item(std::uint64_t h) { return reverse_bits(h) | 1; }
+    static std::uint64_t so_sentinel(std::size_t b) { return reverse_bits(b); }
+
+    std::uint64_t hash(const K& key) const { return static_cast<std::uint64_t>(hasher(key)); }
+
+    // Segment 0 holds buckets [0, 64), segment s > 0 holds [64 << (s - 1), 64 << s)
+    static std::size_t segment_of(std::size_t b) { return b < first_segment ? 0 : static_cast<std::size_t>(std::bit_width(b / first_segment)); }
+    static std::size_t segment_base(std::size_t s) { return s == 0 ? 0 : first_segment << (s - 1); }
+
+    std::atomic<Node*>& bucket(std::size_t b)
+    {
+        std::size_t s = segment_of(b);
+        std::size_t base = segment_base(s);
+        std::atomic<Node*>* segment = segments[s].load(std::memory_order_acquire);
+        if (!segment)
+        {
+            std::atomic<Node*>* fresh = new std::atomic<Node*>[s == 0 ? first_segment : base]();
+            if (segments[s].compare_exchange_strong(segment, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                segment = fresh;
+            }
+            else
+            {
+                delete[] fresh; // Another thread added it first
+            }
+        }
+        return segment[b - base];
+    }
+
+    // The sentinel of bucket b or, while b has none, of its nearest ancestor; allocates nothing
+    Node* nearest_sentinel(std::size_t b)
+    {
+        for (;; b &= ~std::bit_floor(b)) // Bucket 0 always has one
+        {
+            std::size_t s = segment_of(b);
+            if (std::atomic<Node*>* segment = segments[s].load(std::memory_order_acquire))
+            {
+                if (Node* node = segment[b - segment_base(s)].load(std::memory_order_acquire)) return node;
+            }
+        }
+    }
+
+    // The sentinel of bucket b, linking it in after its parent's on first use
+    Node* sentinel(std::size_t b, typename R::Guard& guard)
+    {
+        std::atomic<Node*>& slot = bucket(b);
+        if (Node* node = slot.load(std::memory_order_acquire)) return node;
+
+        Node* parent = sentinel(b & ~std::bit_floor(b), guard);
+        std::uint64_t so = so_sentinel(b);
+        auto order = [so](const Node& node) { return node.so_key < so ? -1 : node.so_key > so ? 1 : 0; };
+
+        typename List::Position pos;
+        Node* node = new Node(so);
+        for (;;)
+        {
+            if (List::find(parent->next, order, guard, pos))
+            {
+                delete node; // Another thread linked it first
+                node = pos.curr;
+                break;
+            }
+            if (List::link(pos, node)) break;
+        }
+        slot.store(node, std::memory_order_release);
+        return node;
+    }
+
+    // Positions `pos` at `key` in its bucket; true if the key is present. Only inserts
+    // add the bucket's sentinel: lookups start from the nearest ancestor's, which
+    // precedes every item of the bucket in split order.
+    bool locate(const K& key, typename R::Guard& guard, typename List::Position& pos, bool add_sentinel)
+    {
+        std::uint64_t h = hash(key);
+        std::uint64_t so = so_item(h);
+        std::size_t b = static_cast<std::size_t>(h) & bucket_mask.load(std::memory_order_acquire);
+        Node* start = add_sentinel ? sentinel(b, guard) : nearest_sentinel(b);
+        auto order = [this, so, &key](const Node& node)
+        {
+            if (node.so_key != so) return node.so_key < so ? -1 : 1;
+            return node.key && equal(*node.key, key) ? 0 : -1; // Same hash, other key: keep looking
+        };
+        return List::find(start->next, order, guard, pos);
+    }
+
+    void grow_if_loaded()
+    {
+        std::size_t items = static_cast<std::size_t>(count.fetch_add(1, std::memory_order_relaxed) + 1);
+        std::size_t mask = bucket_mask.load(std::memory_order_relaxed);
+        if (items > (mask + 1) * max_load && mask + 1 < max_buckets)
+        {
+            bucket_mask.compare_exchange_strong(mask, mask * 2 + 1, std::memory_order_release, std::memory_order_relaxed);
+        }
+    }
+
+    alignas(64) std::atomic<std::size_t> bucket_mask{0};
+    alignas(64) std::atomic<std::int64_t> count{0};
+    std::atomic<std::atomic<Node*>*> segments[max_segments] = {};
+    [[no_unique_address]] Hash hasher;
+    [[no_unique_address]] KeyEqual equal;
+};
@@ -0,0 +1,139 @@
+/*
+
+Benchmark of semaphore-based bounded buffers
+
+MutexBuffer      : std::queue behind std::mutex, admitted by two
+                   std::counting_semaphore, as in Semaphore_Mutex.md.
+SemaphoreBuffer  : semaphore_buffer.hpp with std::counting_semaphore, so the
+                   difference to MutexBuffer is the mutex alone.
+LightSemaphore   : semaphore_buffer.hpp with LightSemaphore.
+
+The argument is the number of producers, with as many consumers. Each run moves
+`items` integers through a buffer of `capacity` slots and reports items/s.
+BM_uncontended_semaphore releases and acquires a permit on one thread.
+
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <semaphore>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "light_semaphore.hpp"
+#include "semaphore_buffer.hpp"
+
+namespace
+{
+
+const std::int64_t items = 1 << 18;
+const std::size_t capacity = 1024;
+
+class MutexBuffer
+{
+public:
+    explicit MutexBuffer(std::size_t capacity_) : empty(static_cast<std::ptrdiff_t>(capacity_)), full(0) {}
+
+    void push(std::int64_t value)
+    {
+        empty.acquire();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            buffer.push(value);
+        }
+        full.release();
+    }
+
+    std::int64_t pop()
+    {
+        full.acquire();
+        std::int64_t value;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            value = buffer.front();
+            buffer.pop();
+        }
+        empty.release();
+        return value;
+    }
+
+private:
+    std::queue<std::int64_t> buffer;
+    std::counting_semaphore<> empty;
+    std::counting_semaphore<> full;
+    std::mutex mtx;
+};
+
+template <typename Buffer>
+void BM_buffer(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+    const std::int64_t per_thread = items / threads;
+    const std::int64_t total = per_thread * threads;
+
+    for (auto _ : state)
+    {
+        Buffer buffer(capacity);
+        std::atomic<std::int64_t> sum{0};
+        {
+            std::vector<std::jthread> workers; // Joined at the end of the block
+            for (int t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&buffer, t, per_thread]
+                {
+                    for (std::int64_t i = 0; i < per_thread; ++i) buffer.push(t * per_thread + i);
+                });
+                workers.emplace_back([&buffer, &sum, per_thread]
+                {
+                    std::int64_t local = 0;
+                    for (std::int64_t i = 0; i < per_thread; ++i) local += buffer.pop();
+                    sum.fetch_add(local, std::memory_order_relaxed);
+                });
+            }
+        }
+
+        // Every value 0 .. total-1 popped once
+        if (sum.load() != total * (total - 1) / 2)
+        {
+            state.SkipWithError("lost items");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+template <typename Semaphore>
+void BM_uncontended_semaphore(benchmark::State& state)
+{
+    Semaphore sem(0);
+    for (auto _ : state)
+    {
+        sem.release();
+        sem.acquire();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void threads_per_side(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("threads");
+    for (int threads : {1, 2, 4, 8, 16})
+    {
+        b->Arg(threads);
+    }
+}
+
+using StdSemaphoreBuffer = SemaphoreBuffer<std::int64_t, std::counting_semaphore<>>;
+using LightSemaphoreBuffer = SemaphoreBuffer<std::int64_t, LightSemaphore>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_buffer, MutexBuffer)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_buffer, StdSemaphoreBuffer)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_buffer, LightSemaphoreBuffer)->Apply(threads_per_side)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_uncontended_semaphore, std::counting_semaphore<>);
+BENCHMARK_TEMPLATE(BM_uncontended_semaphore, LightSemaphore);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,124 @@
+/*
+
+Lightweight counting semaphore
+
+std::counting_semaphore has the right interface, but a release() is not free
+even when nobody waits, and an acquire() on a zero count goes to sleep without
+first giving the releasing thread a moment. LightSemaphore keeps the count in a
+user-space atomic and only enters the kernel when a thread really has to sleep:
+
+- `count` is the number of permits. A negative value means that many threads
+  have given up spinning and sleep (or are about to).
+- acquire() first spins for a short while, taking a permit with a CAS whenever
+  the count is positive. Only then does it decrement unconditionally; if that
+  took the count below zero, it sleeps on `wakeups`.
+- release(n) adds n permits. Only the part that covers sleepers (a negative old
+  count) is handed to `wakeups` with a futex wake; with no sleepers it is a
+  single fetch_add.
+
+`wakeups` is itself a tiny futex semaphore: a sleeper takes one wake-up with a
+CAS and otherwise waits for the word to change, so a release that happens
+before the sleeper reaches the futex is not lost.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include "cpu_relax.hpp"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class LightSemaphore
+{
+public:
+    explicit LightSemaphore(std::ptrdiff_t initial = 0) : count(initial) {}
+
+    LightSemaphore(const LightSemaphore&) = delete;
+    LightSemaphore& operator=(const LightSemaphore&) = delete;
+
+    bool try_acquire()
+    {
+        std::ptrdiff_t old = count.load(std::memory_order_relaxed);
+        while (old > 0)
+        {
+            if (count.compare_exchange_weak(old, old - 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void acquire()
+    {
+        for (int spins = 0; spins < spin_limit; ++spins)
+        {
+            if (try_acquire()) return;
+            cpu_relax();
+        }
+
+        if (count.fetch_sub(1, std::memory_order_acquire) > 0) return;
+        wait_for_wakeup();
+    }
+
+    void release(std::ptrdiff_t n = 1)
+    {
+        std::ptrdiff_t old = count.fetch_add(n, std::memory_order_release);
+        std::ptrdiff_t sleepers = old < 0 ? -old : 0;
+        if (sleepers > 0) post_wakeups(sleepers < n ? sleepers : n);
+    }
+
+private:
+    static constexpr int spin_limit = 64;
+
+    void wait_for_wakeup()
+    {
+        for (;;)
+        {
+            std::uint32_t w = wakeups.load(std::memory_order_relaxed);
+            while (w > 0)
+            {
+                if (wakeups.compare_exchange_weak(w, w - 1, std::memory_order_acquire, std::memory_order_relaxed)) return;
+            }
+            sleep();
+        }
+    }
+
+    void post_wakeups(std::ptrdiff_t n)
+    {
+        wakeups.fetch_add(static_cast<std::uint32_t>(n), std::memory_order_release);
+        wake(n > INT_MAX ? INT_MAX : static_cast<int>(n));
+    }
+
+    // Returns once `wakeups` may have become non-zero; may also return spuriously
+    void sleep()
+    {
+#ifdef __linux__
+        static_assert(sizeof(wakeups) == sizeof(std::uint32_t), "futex needs a plain 32-bit word");
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&wakeups), FUTEX_WAIT_PRIVATE, 0, nullptr, nullptr, 0);
+#else
+        wakeups.wait(0, std::memory_order_relaxed);
+#endif
+    }
+
+    void wake([[maybe_unused]] int n)
+    {
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&wakeups), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+#else
+        if (n == 1) wakeups.notify_one();
+        else wakeups.notify_all();
+#endif
+    }
+
+    alignas(64) std::atomic<std::ptrdiff_t> count;
+    std::atomic<std::uint32_t> wakeups{0};
+};
@@ -0,0 +1,76 @@
+/*
+
+Bounded buffer with semaphores and no mutex
+
+The multiple producers / multiple consumers example of Semaphore_Mutex.md on a
+SemaphoreBuffer (semaphore_buffer.hpp): `empty` and `full` still admit the
+threads, but the slots are handed out with atomic tickets instead of a
+std::queue behind std::mutex mtx. The semaphores are LightSemaphores
+(light_semaphore.hpp), which only make a syscall when a thread has to sleep.
+
+Each producer makes ITEMS items, so the program ends.
+
+*/
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "semaphore_buffer.hpp"
+
+const int BUFFER_SIZE = 10;
+const int ITEMS = 20;
+
+SemaphoreBuffer<int> buffer(BUFFER_SIZE);
+
+void producer(int id)
+{
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        int item = id * 100 + i; // Produce an item
+        buffer.push(item);
+
+        std::ostringstream line;
+        line << "Producer " << id << " produced item " << item << "\n";
+        std::cout << line.str();
+    }
+}
+
+void consumer(int id)
+{
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        int item = buffer.pop();
+
+        std::ostringstream line;
+        line << "Consumer " << id << " consumed item " << item << "\n";
+        std::cout << line.str();
+    }
+}
+
+int main()
+{
+    const int num_producers = 3;
+    const int num_consumers = 3;
+    std::vector<std::thread> producers, consumers;
+
+    for (int i = 0; i < num_producers; ++i)
+    {
+        producers.emplace_back(producer, i);
+    }
+    for (int i = 0; i < num_consumers; ++i)
+    {
+        consumers.emplace_back(consumer, i);
+    }
+
+    for (auto& t : producers)
+    {
+        t.join();
+    }
+    for (auto& t : consumers)
+    {
+        t.join();
+    }
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+
+Bounded buffer on two semaphores, without the mutex
+
+The semaphore solution of Semaphore_Mutex.md already counts free and filled
+slots with `empty` and `full`, so the buffer can never overflow or underflow;
+the mutex around buffer.push / buffer.pop only serialises access to the
+std::queue. SemaphoreBuffer<T> replaces the queue with a fixed array and hands
+out slots with atomic tickets:
+
+- push: empty.acquire() admits the producer, tail.fetch_add(1) gives it ticket
+  t and slot t % capacity, then full.release() admits one consumer.
+- pop: full.acquire(), head.fetch_add(1), then empty.release().
+
+Admission alone does not say that *this* slot is ready: the consumer holding
+ticket t may have been admitted by the producer of ticket t + 1, and a producer
+may get a slot whose consumer from the previous lap is still moving the item
+out. Each slot therefore has a `turn` counter; lap r of a slot belongs to the
+producer while turn == 2r and to the consumer while turn == 2r + 1. The wait on
+`turn` only covers another thread's copy in progress, so it spins and yields.
+
+A ticket cannot be handed back, so nothing may throw between taking one and
+advancing `turn`: T must be nothrow move constructible, and push() builds a T
+from any other argument before it takes a ticket.
+
+Semaphore defaults to LightSemaphore (light_semaphore.hpp); any type with a
+count constructor, acquire() and release() works, e.g. std::counting_semaphore<>.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "cpu_relax.hpp"
+#include "light_semaphore.hpp"
+
+template <typename T, typename Semaphore = LightSemaphore>
+class SemaphoreBuffer
+{
+    static_assert(std::is_nothrow_move_constructible_v<T>, "a throw while an item moves into or out of a slot would leave its turn stuck");
+
+public:
+    explicit SemaphoreBuffer(std::size_t capacity_)
+        : size_(capacity_ ? capacity_ : 1),
+          slots(std::make_unique<Slot[]>(size_)),
+          empty(static_cast<std::ptrdiff_t>(size_)),
+          full(0)
+    {
+    }
+
+    SemaphoreBuffer(const SemaphoreBuffer&) = delete;
+    SemaphoreBuffer& operator=(const SemaphoreBuffer&) = delete;
+
+    ~SemaphoreBuffer()
+    {
+        for (std::size_t i = head.load(std::memory_order_relaxed); i != tail.load(std::memory_order_relaxed); ++i)
+        {
+            std::destroy_at(slots[i % size_].item());
+        }
+    }
+
+    template <typename U>
+    void push(U&& value)
+    {
+        if constexpr (!std::is_nothrow_constructible_v<T, U&&>)
+        {
+            push(T(std::forward<U>(value))); // May throw, so before the slot is taken
+            return;
+        }
+        empty.acquire();
+
+        std::size_t ticket = tail.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[ticket % size_];
+        std::size_t lap = ticket / size_;
+        wait_for_turn(slot, 2 * lap);
+
+        std::construct_at(slot.item(), std::forward<U>(value));
+        slot.turn.store(2 * lap + 1, std::memory_order_release);
+
+        full.release();
+    }
+
+    T pop()
+    {
+        full.acquire();
+
+        std::size_t ticket = head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[ticket % size_];
+        std::size_t lap = ticket / size_;
+        wait_for_turn(slot, 2 * lap + 1);
+
+        T value(std::move(*slot.item()));
+        std::destroy_at(slot.item());
+        slot.turn.store(2 * lap + 2, std::memory_order_release);
+
+        empty.release();
+        return value;
+    }
+
+    std::size_t capacity() const { return size_; }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> turn{0};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return reinterpret_cast<T*>(storage); }
+    };
+
+    static void wait_for_turn(Slot& slot, std::size_t turn)
+    {
+        for (int spins = 0; slot.turn.load(std::memory_order_acquire) != turn; ++spins)
+        {
+            if (spins < 64) cpu_relax();
+            else std::this_thread::yield();
+        }
+    }
+
+    // Read-only after construction
+    const std::size_t size_;
+    const std::unique_ptr<Slot[]> slots;
+
+    Semaphore empty;
+    Semaphore full;
+
+    alignas(64) std::atomic<std::size_t> tail{0};
+    alignas(64) std::atomic<std::size_t> head{0};
+};
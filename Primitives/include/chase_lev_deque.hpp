@@ -0,0 +1,138 @@
+/*
+
+Chase-Lev work-stealing deque
+
+The deque of the fork-join pool (Fork_Join_Design_Pattern/src/fork_join_pool.hpp)
+and of ThreadPool (std_condition_variable/src/thread_pool.hpp): the owner
+pushes and pops at the bottom without a lock, thieves take the oldest
+item from the top with one CAS. The array grows when full; old arrays are kept
+until the deque is destroyed because a thief may still be reading one.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+// push() and pop() are called by the owner only, steal() by any other thread.
+template <typename T>
+class ChaseLevDeque
+{
+    static_assert(std::is_pointer_v<T>, "ChaseLevDeque stores pointers");
+
+public:
+    explicit ChaseLevDeque(std::size_t capacity = 1024)
+    {
+        std::size_t size = 1;
+        while (size < capacity) size <<= 1;
+        arrays.push_back(std::make_unique<Array>(size));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    void push(T item)
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+
+        if (b - t > static_cast<std::int64_t>(a->size) - 1)
+        {
+            a = grow(a, t, b);
+        }
+
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    T pop()
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // Deque was already empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T item = a->get(b);
+        if (t == b)
+        {
+            // Last element: race against thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                item = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    T steal()
+    {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b) return nullptr;
+
+        Array* a = array.load(std::memory_order_acquire);
+        T item = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return nullptr; // Lost the race with the owner or another thief
+        }
+        return item;
+    }
+
+    bool empty() const
+    {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array
+    {
+        std::size_t size;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Array(std::size_t size_) : size(size_), slots(new std::atomic<T>[size_]) {}
+
+        T get(std::int64_t i) const { return slots[i & (size - 1)].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, T item) { slots[i & (size - 1)].store(item, std::memory_order_relaxed); }
+    };
+
+    Array* grow(Array* old, std::int64_t t, std::int64_t b)
+    {
+        auto bigger = std::make_unique<Array>(old->size * 2);
+        for (std::int64_t i = t; i < b; ++i)
+        {
+            bigger->put(i, old->get(i));
+        }
+
+        // Thieves may still be reading the old array, so it is kept until destruction
+        Array* a = bigger.get();
+        arrays.push_back(std::move(bigger));
+        array.store(a, std::memory_order_release);
+        return a;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top{0};
+    alignas(64) std::atomic<std::int64_t> bottom{0};
+    alignas(64) std::atomic<Array*> array{nullptr};
+    std::vector<std::unique_ptr<Array>> arrays;
+};
@@ -0,0 +1,24 @@
+/*
+
+Pause hint for spin loops
+
+Tells the core that the thread is busy-waiting: on x86 the pause instruction
+saves power and frees the pipeline for the sibling hyper-thread, and it avoids
+the memory-order mis-speculation penalty when the awaited store arrives.
+
+*/
+
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
@@ -0,0 +1,117 @@
+/*
+
+Event count
+
+A condition variable without a mutex, for lock-free or sharded data structures.
+A consumer that found nothing registers as a waiter, checks its condition once
+more, and only then sleeps:
+
+    auto key = events.prepare_wait();
+    if (try_pop(item)) { events.cancel_wait(); return item; }
+    events.wait(key);
+
+A producer publishes its item and calls notify_one(). When nobody waits this is
+a single load, with no syscall and no shared lock. Otherwise it bumps the epoch
+and wakes a sleeper.
+
+The sleep is a futex wait on the epoch (std::atomic::wait elsewhere; libstdc++
+spins and yields there before sleeping, which hurts with many more threads than
+cores). A notification that happens between prepare_wait() and wait() changes
+the epoch, so wait() returns at once and no wake-up is lost.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class EventCount
+{
+public:
+    using Key = std::uint32_t;
+
+    Key prepare_wait()
+    {
+        // seq_cst: ordered before the consumer's re-check, and against the producer's
+        // fence in notify, so that one of the two always sees the other (Dekker)
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        return epoch.load(std::memory_order_seq_cst);
+    }
+
+    void cancel_wait() { waiters.fetch_sub(1, std::memory_order_relaxed); }
+
+    void wait(Key key)
+    {
+        while (epoch.load(std::memory_order_acquire) == key)
+        {
+            sleep(key);
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify_one()
+    {
+        if (has_waiters())
+        {
+            epoch.fetch_add(1, std::memory_order_release);
+            wake(1);
+        }
+    }
+
+    void notify_all()
+    {
+        if (has_waiters())
+        {
+            epoch.fetch_add(1, std::memory_order_release);
+            wake(INT_MAX);
+        }
+    }
+
+private:
+    // Returns at once if the epoch is no longer `key`; may also return spuriously
+    void sleep(Key key)
+    {
+#ifdef __linux__
+        syscall(SYS_futex, epoch_word(), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+#else
+        epoch.wait(key, std::memory_order_acquire);
+#endif
+    }
+
+    void wake([[maybe_unused]] int count)
+    {
+#ifdef __linux__
+        syscall(SYS_futex, epoch_word(), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+        if (count == 1) epoch.notify_one();
+        else epoch.notify_all();
+#endif
+    }
+
+#ifdef __linux__
+    // The futex is the 32-bit value inside the atomic
+    std::uint32_t* epoch_word()
+    {
+        static_assert(sizeof(epoch) == sizeof(std::uint32_t), "futex needs a plain 32-bit word");
+        return reinterpret_cast<std::uint32_t*>(&epoch);
+    }
+#endif
+
+    bool has_waiters() const
+    {
+        // Orders the caller's publication of new state before the waiters check
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return waiters.load(std::memory_order_relaxed) != 0;
+    }
+
+    alignas(64) std::atomic<std::uint32_t> epoch{0};
+    alignas(64) std::atomic<std::uint32_t> waiters{0};
+};
@@ -0,0 +1,49 @@
+/*
+
+Spin lock for very short critical sections
+
+Test-and-test-and-set: a waiting thread spins on a plain load, which stays in
+its own cache, and only retries the exchange once the lock looks free. After a
+few rounds of spinning it yields, so a preempted owner can run again.
+
+Meets the Lockable requirements, so it works with std::lock_guard.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include "cpu_relax.hpp"
+
+class SpinLock
+{
+public:
+    void lock()
+    {
+        for (int spins = 0; locked.exchange(true, std::memory_order_acquire); )
+        {
+            while (locked.load(std::memory_order_relaxed))
+            {
+                if (++spins < 64)
+                {
+                    cpu_relax();
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    bool try_lock()
+    {
+        return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() { locked.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> locked{false};
+};
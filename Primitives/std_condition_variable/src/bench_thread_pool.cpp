@@ -0,0 +1,283 @@
+/*
+
+Benchmark of thread pools on tiny tasks
+
+MutexThreadPool : the ThreadPool of std_condition_variable.md, one std::queue
+                  behind one mutex and one condition variable (tasks moved
+                  instead of copied).
+ThreadPool      : thread_pool.hpp, work-stealing.
+
+BM_external       : the benchmark thread enqueues `tasks` empty tasks.
+BM_external_large : same, each task capturing 128 bytes, more than the inline
+                    buffer of either pool.
+BM_nested         : one task starts a binary tree of tasks, each node
+                    enqueueing its two children from inside the pool, `tasks`
+                    nodes in total.
+BM_submit         : `futures` calls of ThreadPool::submit, then a get() on
+                    each future.
+BM_async          : the same with std::async(std::launch::async), one thread
+                    per call, without a pool (the argument is ignored).
+
+The argument is the number of worker threads. The pool is built once per
+benchmark and warmed up with one untimed round; each iteration waits until
+every task has run. Reports tasks/s and allocs/task, the number of calls to the
+global operator new per task.
+
+*/
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "thread_pool.hpp"
+
+namespace
+{
+
+std::atomic<std::int64_t> allocations{0};
+
+} // namespace
+
+// Every call is counted for allocs/task
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+const std::int64_t tasks = 1 << 17;
+const std::int64_t futures = 1 << 12;
+
+class MutexThreadPool
+{
+public:
+    explicit MutexThreadPool(std::size_t numThreads)
+    {
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            workers.emplace_back(&MutexThreadPool::workerThread, this);
+        }
+    }
+
+    ~MutexThreadPool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    void enqueueTask(std::function<void()> task)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            queue.push(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+private:
+    void workerThread()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this] { return !queue.empty() || stop; });
+                if (stop && queue.empty()) return;
+                task = std::move(queue.front());
+                queue.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> queue;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stop = false;
+};
+
+void wait_for(const std::atomic<std::int64_t>& done, std::int64_t count)
+{
+    while (done.load(std::memory_order_acquire) < count)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void report(benchmark::State& state, std::int64_t allocs_before, std::int64_t per_iteration = tasks)
+{
+    std::int64_t count = state.iterations() * per_iteration;
+    state.SetItemsProcessed(count);
+    state.counters["allocs/task"] = static_cast<double>(allocations.load() - allocs_before) / static_cast<double>(count);
+}
+
+template <typename Pool, std::size_t CaptureBytes>
+void external(benchmark::State& state)
+{
+    Pool pool(static_cast<std::size_t>(state.range(0)));
+    std::atomic<std::int64_t> done{0};
+    std::array<char, CaptureBytes> payload{};
+
+    auto round = [&]
+    {
+        done.store(0);
+        for (std::int64_t i = 0; i < tasks; ++i)
+        {
+            pool.enqueueTask([&done, payload]
+            {
+                benchmark::DoNotOptimize(payload);
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        wait_for(done, tasks);
+    };
+
+    round(); // Warm-up: lets the queues and the slab grow to their peak size
+    std::int64_t allocs_before = allocations.load();
+    for (auto _ : state)
+    {
+        round();
+    }
+    report(state, allocs_before);
+}
+
+template <typename Pool>
+void BM_external(benchmark::State& state)
+{
+    external<Pool, 1>(state);
+}
+
+template <typename Pool>
+void BM_external_large(benchmark::State& state)
+{
+    external<Pool, 128>(state);
+}
+
+// Node `index` of a complete binary tree with `count` nodes enqueues its children
+template <typename Pool>
+void tree_node(Pool& pool, std::atomic<std::int64_t>& done, std::int64_t index, std::int64_t count)
+{
+    for (std::int64_t child = 2 * index + 1; child <= 2 * index + 2 && child < count; ++child)
+    {
+        pool.enqueueTask([&pool, &done, child, count] { tree_node(pool, done, child, count); });
+    }
+    done.fetch_add(1, std::memory_order_release);
+}
+
+template <typename Pool>
+void BM_nested(benchmark::State& state)
+{
+    Pool pool(static_cast<std::size_t>(state.range(0)));
+    std::atomic<std::int64_t> done{0};
+
+    auto round = [&]
+    {
+        done.store(0);
+        pool.enqueueTask([&pool, &done] { tree_node(pool, done, 0, tasks); });
+        wait_for(done, tasks);
+    };
+
+    round(); // Warm-up
+    std::int64_t allocs_before = allocations.load();
+    for (auto _ : state)
+    {
+        round();
+    }
+    report(state, allocs_before);
+}
+
+void BM_submit(benchmark::State& state)
+{
+    ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::future<std::int64_t>> results(futures);
+
+    auto round = [&]
+    {
+        for (std::int64_t i = 0; i < futures; ++i)
+        {
+            results[static_cast<std::size_t>(i)] = pool.submit([](std::int64_t x) { return x * 2; }, i);
+        }
+        std::int64_t sum = 0;
+        for (std::future<std::int64_t>& result : results)
+        {
+            sum += result.get();
+        }
+        benchmark::DoNotOptimize(sum);
+    };
+
+    round(); // Warm-up
+    std::int64_t allocs_before = allocations.load();
+    for (auto _ : state)
+    {
+        round();
+    }
+    report(state, allocs_before, futures);
+}
+
+void BM_async(benchmark::State& state)
+{
+    std::vector<std::future<std::int64_t>> results(futures);
+
+    std::int64_t allocs_before = allocations.load();
+    for (auto _ : state)
+    {
+        for (std::int64_t i = 0; i < futures; ++i)
+        {
+            results[static_cast<std::size_t>(i)] = std::async(std::launch::async, [](std::int64_t x) { return x * 2; }, i);
+        }
+        std::int64_t sum = 0;
+        for (std::future<std::int64_t>& result : results)
+        {
+            sum += result.get();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    report(state, allocs_before, futures);
+}
+
+void worker_counts(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("workers");
+    for (int workers : {1, 2, 4, 8})
+    {
+        b->Arg(workers);
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_external, MutexThreadPool)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_external, ThreadPool)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_external_large, MutexThreadPool)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_external_large, ThreadPool)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_nested, MutexThreadPool)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_nested, ThreadPool)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_submit)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_async)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,260 @@
+/*
+
+Slab allocator for small, short-lived objects
+
+Closures too big for a task's inline buffer, and the tasks themselves, are
+allocated and freed at the rate tasks are enqueued and run. SlabAllocator keeps
+freed blocks for reuse instead of handing them back to malloc:
+
+- Blocks come in size classes of 64, 128, ..., 2048 bytes. Larger requests go
+  straight to operator new.
+- A class that runs dry takes a chunk of `blocks_per_chunk` blocks from
+  operator new at once. Chunks are only released when the allocator is
+  destroyed, so in steady state no call reaches malloc.
+- The allocator can be built with a number of per-thread caches; a thread
+  claims one with bind_thread() (ThreadPool binds each worker to its own).
+  A bound thread allocates from and frees to its cache without any lock or
+  atomic operation. Only when a cache runs dry does it take `cache_batch`
+  blocks from the shared class under its SpinLock, and when it holds twice
+  that many it hands `cache_batch` back with one CAS. Blocks thus flow from
+  the workers that free them to the threads that allocate them in batches.
+- An unbound thread works on the shared class directly. Blocks are usually
+  freed on another thread than the one that allocated them (a task is created
+  by the submitter and destroyed by a worker), so deallocate() pushes onto a
+  lock-free `returned` stack, which only ever sees pushes and whole-stack
+  exchanges and so has no ABA problem. allocate() takes a block from the
+  class's `local` list under the SpinLock and, when that is empty, grabs the
+  whole `returned` stack with one exchange.
+
+Blocks are aligned for any scalar type (alignof(std::max_align_t)).
+
+SlabAllocatorAdapter<T> lets standard components that take an allocator (such
+as std::promise) allocate from a SlabAllocator. It shares ownership of the slab,
+so memory handed out through it stays valid after the slab's original owner is
+gone.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "spin_lock.hpp"
+
+class SlabAllocator
+{
+public:
+    static constexpr std::size_t min_block = 64;
+    static constexpr std::size_t classes = 6;
+    static constexpr std::size_t max_block = min_block << (classes - 1);
+    static constexpr std::size_t blocks_per_chunk = 64;
+    static constexpr std::size_t cache_batch = 32; // Blocks moved between a cache and the shared class at once
+
+    explicit SlabAllocator(std::size_t caches_ = 0) : caches(caches_) {}
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    ~SlabAllocator()
+    {
+        for (SizeClass& c : size_classes)
+        {
+            for (void* chunk : c.chunks)
+            {
+                ::operator delete(chunk);
+            }
+        }
+    }
+
+    // Gives cache `index` to the calling thread until unbind_thread(); no other thread may use it
+    void bind_thread(std::size_t index) { binding = Binding{this, &caches[index]}; }
+    static void unbind_thread() { binding = Binding{nullptr, nullptr}; }
+
+    void* allocate(std::size_t bytes)
+    {
+        if (bytes > max_block) return ::operator new(bytes);
+
+        std::size_t index = class_of(bytes);
+        SizeClass& c = size_classes[index];
+        if (Cache* cache = bound_cache())
+        {
+            FreeList& list = cache->lists[index];
+            if (!list.head)
+            {
+                std::lock_guard<SpinLock> lock(c.lock);
+                for (; list.count < cache_batch; ++list.count)
+                {
+                    Block* block = take(c, index);
+                    block->next = list.head;
+                    list.head = block;
+                }
+            }
+            Block* block = list.head;
+            list.head = block->next;
+            --list.count;
+            return block;
+        }
+
+        std::lock_guard<SpinLock> lock(c.lock);
+        return take(c, index);
+    }
+
+    void deallocate(void* p, std::size_t bytes)
+    {
+        if (bytes > max_block)
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        std::size_t index = class_of(bytes);
+        Block* block = static_cast<Block*>(p);
+        if (Cache* cache = bound_cache())
+        {
+            FreeList& list = cache->lists[index];
+            block->next = list.head;
+            list.head = block;
+            if (++list.count < 2 * cache_batch) return;
+
+            // Hand the newest cache_batch blocks back, keep the others
+            Block* last = block;
+            for (std::size_t i = 1; i < cache_batch; ++i)
+            {
+                last = last->next;
+            }
+            list.head = last->next;
+            list.count -= cache_batch;
+            give_back(size_classes[index], block, last);
+            return;
+        }
+
+        give_back(size_classes[index], block, block);
+    }
+
+private:
+    struct Block
+    {
+        Block* next;
+    };
+
+    struct FreeList
+    {
+        Block* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    struct alignas(64) Cache
+    {
+        FreeList lists[classes];
+    };
+
+    struct Binding
+    {
+        const SlabAllocator* slab;
+        Cache* cache;
+    };
+
+    static inline thread_local Binding binding{nullptr, nullptr};
+
+    Cache* bound_cache() const { return binding.slab == this ? binding.cache : nullptr; }
+
+    struct alignas(64) SizeClass
+    {
+        SpinLock lock;
+        Block* local = nullptr;                  // Under `lock`
+        std::atomic<Block*> returned{nullptr};   // Pushed by any thread
+        std::vector<void*> chunks;               // Under `lock`
+    };
+
+    static std::size_t class_of(std::size_t bytes)
+    {
+        return bytes <= min_block ? 0 : static_cast<std::size_t>(std::bit_width((bytes - 1) / min_block));
+    }
+
+    // Called with the class lock held
+    static Block* take(SizeClass& c, std::size_t index)
+    {
+        if (!c.local)
+        {
+            c.local = c.returned.exchange(nullptr, std::memory_order_acquire);
+            if (!c.local) refill(c, min_block << index);
+        }
+        Block* block = c.local;
+        c.local = block->next;
+        return block;
+    }
+
+    // Pushes the chain first..last onto the class's `returned` stack
+    static void give_back(SizeClass& c, Block* first, Block* last)
+    {
+        last->next = c.returned.load(std::memory_order_relaxed);
+        while (!c.returned.compare_exchange_weak(last->next, first, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Called with the class lock held
+    static void refill(SizeClass& c, std::size_t block_size)
+    {
+        char* chunk = static_cast<char*>(::operator new(block_size * blocks_per_chunk));
+        c.chunks.push_back(chunk);
+        for (std::size_t i = blocks_per_chunk; i-- > 0; )
+        {
+            Block* block = reinterpret_cast<Block*>(chunk + i * block_size);
+            block->next = c.local;
+            c.local = block;
+        }
+    }
+
+    SizeClass size_classes[classes];
+    std::vector<Cache> caches;
+};
+
+template <typename T>
+class SlabAllocatorAdapter
+{
+public:
+    using value_type = T;
+
+    explicit SlabAllocatorAdapter(std::shared_ptr<SlabAllocator> slab_) noexcept : slab(std::move(slab_)) {}
+
+    template <typename U>
+    SlabAllocatorAdapter(const SlabAllocatorAdapter<U>& other) noexcept : slab(other.slab) {}
+
+    T* allocate(std::size_t n)
+    {
+        if constexpr (alignof(T) > alignof(std::max_align_t))
+        {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        else
+        {
+            return static_cast<T*>(slab->allocate(n * sizeof(T)));
+        }
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if constexpr (alignof(T) > alignof(std::max_align_t))
+        {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+        }
+        else
+        {
+            slab->deallocate(p, n * sizeof(T));
+        }
+    }
+
+    template <typename U>
+    bool operator==(const SlabAllocatorAdapter<U>& other) const noexcept { return slab == other.slab; }
+
+private:
+    template <typename U>
+    friend class SlabAllocatorAdapter;
+
+    std::shared_ptr<SlabAllocator> slab;
+};
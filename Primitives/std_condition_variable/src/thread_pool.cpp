@@ -0,0 +1,66 @@
+/*
+
+Work-stealing thread pool
+
+The thread pool example of std_condition_variable.md on the work-stealing
+ThreadPool (thread_pool.hpp). enqueueTask has the same signature; the
+destructor runs the tasks still queued, so main() does not need to sleep.
+
+The second half enqueues tasks from inside a task: those go to the worker's own
+deque without a lock, and idle workers steal them. The last task owns a
+std::unique_ptr, which a std::function could not hold.
+
+Finally submit() and submit_batch() hand results back through std::future
+instead of std::async.
+
+*/
+
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "thread_pool.hpp"
+
+int main()
+{
+    ThreadPool pool(4);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.enqueueTask([i]
+        {
+            std::ostringstream line;
+            line << "Task " << i << " is being processed\n";
+            std::cout << line.str();
+        });
+    }
+
+    pool.enqueueTask([&pool]
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            pool.enqueueTask([i]
+            {
+                std::ostringstream line;
+                line << "Subtask " << i << " is being processed on thread " << std::this_thread::get_id() << "\n";
+                std::cout << line.str();
+            });
+        }
+    });
+
+    auto report = std::make_unique<std::string>("Move-only task is being processed\n");
+    pool.enqueueTask([report = std::move(report)] { std::cout << *report; });
+
+    std::future<int> sum = pool.submit([](int a, int b) { return a + b; }, 20, 22);
+    std::cout << "submit: 20 + 22 = " + std::to_string(sum.get()) + "\n";
+
+    std::vector<int> values(1000);
+    std::iota(values.begin(), values.end(), 1);
+    std::atomic<long> total{0};
+    pool.submit_batch(values, [&total](int value) { total.fetch_add(value, std::memory_order_relaxed); }, 100).get();
+    std::cout << "submit_batch: sum of 1..1000 = " + std::to_string(total.load()) + "\n";
+}
@@ -0,0 +1,400 @@
+/*
+
+Work-stealing thread pool
+
+The ThreadPool of std_condition_variable.md keeps every task in one
+std::queue behind one mutex and one condition variable, so every enqueueTask and
+every dequeue by every worker goes through the same lock. This ThreadPool has
+the same interface and gives each worker its own queue:
+
+- A task enqueued by a worker (a task that enqueues more tasks) goes onto that
+  worker's Chase-Lev deque (chase_lev_deque.hpp). The owner pops its newest
+  task without a lock (LIFO, still hot in its cache); idle workers steal the
+  oldest one from the other end with a single CAS (FIFO).
+- A task enqueued by any other thread goes into the injection queue. A worker
+  that takes from it moves up to `inject_batch` tasks to its own deque at once,
+  so the lock is taken once per batch rather than once per task.
+- An idle worker spins and yields for a while, then parks on an EventCount.
+  enqueueTask only makes a wake-up call when a worker is parked.
+- The destructor runs every task already enqueued, as the original does, and
+  then joins the workers.
+
+Enqueueing does not allocate once the pool has warmed up. A task is a
+move-only UniqueFunction (unique_function.hpp) rather than a std::function, so
+it is moved into the pool, never copied, and move-only captures work. Captures
+of up to InlineSize bytes (64 for ThreadPool) are stored in the task itself;
+the task nodes, and larger captures unless `slab_closures` is false, come from
+the pool's SlabAllocator (slab_allocator.hpp), which recycles the blocks freed
+by finished tasks. Each worker has its own slab cache, so a worker that frees
+a finished task or enqueues a new one takes no lock; only the thread that
+enqueues from outside, and a cache that runs dry or overflows, touch the
+shared free lists.
+
+submit(f, args...) runs f(args...) on the pool and returns a std::future of
+its result, the pool's replacement for std::async. The future's shared state is
+allocated from the pool's slab through SlabAllocatorAdapter, so a submit whose
+callable fits the task's inline buffer does not reach malloc either. Exceptions
+thrown by f are stored in the future.
+
+submit_batch(range, f, grain) calls f on every element of a forward range,
+`grain` consecutive elements per task, and returns one std::future<void> that
+becomes ready when all of them have run; it holds the first exception thrown,
+if any. The range must stay alive until then.
+
+Waiting on a future from inside a task blocks that worker; with as many waits as
+workers, the pool deadlocks.
+
+There is no global order between tasks: a worker runs its own tasks newest
+first.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <ranges>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "chase_lev_deque.hpp"
+#include "cpu_relax.hpp"
+#include "event_count.hpp"
+#include "slab_allocator.hpp"
+#include "unique_function.hpp"
+
+template <std::size_t InlineSize = 64>
+class BasicThreadPool
+{
+public:
+    using Function = UniqueFunction<void(), InlineSize>;
+
+    explicit BasicThreadPool(std::size_t numThreads = std::thread::hardware_concurrency(), bool slab_closures_ = true)
+        : slab_closures(slab_closures_), slab(std::make_shared<SlabAllocator>(std::max<std::size_t>(numThreads, 1)))
+    {
+        if (numThreads == 0) numThreads = 1;
+
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            workers.push_back(std::make_unique<Worker>());
+            workers.back()->pool = this;
+            workers.back()->index = i;
+            workers.back()->rng.seed(static_cast<unsigned>(i) + 1);
+        }
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            threads.emplace_back(&BasicThreadPool::workerThread, this, workers[i].get());
+        }
+    }
+
+    ~BasicThreadPool()
+    {
+        stop.store(true, std::memory_order_seq_cst);
+        idle.notify_all();
+        for (std::thread& worker : threads)
+        {
+            worker.join();
+        }
+    }
+
+    BasicThreadPool(const BasicThreadPool&) = delete;
+    BasicThreadPool& operator=(const BasicThreadPool&) = delete;
+
+    template <typename F>
+    void enqueueTask(F&& task)
+    {
+        void* node = slab->allocate(sizeof(Task));
+        Task* t = nullptr;
+        try
+        {
+            if constexpr (std::is_same_v<std::decay_t<F>, Function>)
+            {
+                t = ::new (node) Task{std::forward<F>(task)};
+            }
+            else
+            {
+                t = ::new (node) Task{Function(std::forward<F>(task), slab_closures ? slab.get() : nullptr)};
+            }
+        }
+        catch (...)
+        {
+            slab->deallocate(node, sizeof(Task));
+            throw;
+        }
+        push(t);
+    }
+
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+        std::promise<R> promise(std::allocator_arg, SlabAllocatorAdapter<R>(slab));
+        std::future<R> future = promise.get_future();
+        enqueueTask([promise = std::move(promise), fn = std::forward<F>(f),
+                     bound = std::make_tuple(std::forward<Args>(args)...)]() mutable
+        {
+            try
+            {
+                if constexpr (std::is_void_v<R>)
+                {
+                    std::apply(std::move(fn), std::move(bound));
+                    promise.set_value();
+                }
+                else
+                {
+                    promise.set_value(std::apply(std::move(fn), std::move(bound)));
+                }
+            }
+            catch (...)
+            {
+                promise.set_exception(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    template <std::ranges::forward_range Range, typename F>
+    std::future<void> submit_batch(Range&& range, F&& f, std::size_t grain = 1)
+    {
+        using Iterator = std::ranges::iterator_t<Range>;
+        using Sentinel = std::ranges::sentinel_t<Range>;
+        using State = Batch<std::decay_t<F>>;
+
+        if (grain == 0) grain = 1;
+        std::promise<void> promise(std::allocator_arg, SlabAllocatorAdapter<void>(slab));
+        std::future<void> future = promise.get_future();
+
+        Iterator first = std::ranges::begin(range);
+        Sentinel last = std::ranges::end(range);
+        std::size_t chunks = 0;
+        for (Iterator it = first; it != last; it = std::ranges::next(it, static_cast<std::ranges::range_difference_t<Range>>(grain), last))
+        {
+            ++chunks;
+        }
+        if (chunks == 0)
+        {
+            promise.set_value();
+            return future;
+        }
+
+        // One state shared by every chunk; the chunk that finishes last completes the future and frees it
+        State* state = ::new (slab->allocate(sizeof(State))) State{std::forward<F>(f), std::move(promise), chunks, {}, {}};
+        for (Iterator it = first; it != last; )
+        {
+            Iterator end = std::ranges::next(it, static_cast<std::ranges::range_difference_t<Range>>(grain), last);
+            enqueueTask([this, state, it, end]
+            {
+                for (Iterator element = it; element != end; ++element)
+                {
+                    if (state->failed.load(std::memory_order_relaxed)) break; // Skip the rest once something threw
+                    try
+                    {
+                        std::invoke(state->fn, *element);
+                    }
+                    catch (...)
+                    {
+                        if (!state->failed.exchange(true, std::memory_order_relaxed)) state->error = std::current_exception();
+                    }
+                }
+                finish(state);
+            });
+            it = end;
+        }
+        return future;
+    }
+
+    std::size_t size() const { return workers.size(); }
+
+private:
+    static constexpr int spin_rounds = 32;
+    static constexpr int yield_rounds = 16;
+    static constexpr std::size_t inject_batch = 32;
+
+    struct Task
+    {
+        Function fn;
+        Task* next = nullptr; // In the injection queue
+    };
+
+    template <typename F>
+    struct Batch
+    {
+        F fn;
+        std::promise<void> done;
+        std::atomic<std::size_t> remaining;
+        std::atomic<bool> failed{false};
+        std::exception_ptr error; // Written by the first chunk that sets `failed`
+    };
+
+    template <typename F>
+    void finish(Batch<F>* state)
+    {
+        if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+        if (state->error) state->done.set_exception(state->error);
+        else state->done.set_value();
+        state->~Batch();
+        slab->deallocate(state, sizeof(Batch<F>));
+    }
+
+    struct Worker
+    {
+        BasicThreadPool* pool = nullptr;
+        std::size_t index = 0; // Also the worker's slab cache
+        ChaseLevDeque<Task*> deque;
+        std::minstd_rand rng;
+    };
+
+    static inline thread_local Worker* current = nullptr;
+
+    void push(Task* task)
+    {
+        if (current && current->pool == this)
+        {
+            current->deque.push(task);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(inject_mutex);
+            if (injected_tail) injected_tail->next = task;
+            else injected_head = task;
+            injected_tail = task;
+            injected_count.store(injected_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        idle.notify_one(); // Only a load when no worker is parked
+    }
+
+    void workerThread(Worker* self)
+    {
+        current = self;
+        slab->bind_thread(self->index); // Tasks this worker frees or enqueues skip the slab's shared lock
+        while (true)
+        {
+            if (Task* task = find_task(self))
+            {
+                run(task);
+                continue;
+            }
+
+            // New work usually shows up quickly: spin, then yield, then park
+            Task* task = nullptr;
+            for (int round = 0; round < spin_rounds + yield_rounds && !task; ++round)
+            {
+                if (round < spin_rounds) cpu_relax();
+                else std::this_thread::yield();
+                task = find_task(self);
+            }
+            if (task)
+            {
+                run(task);
+                continue;
+            }
+
+            EventCount::Key key = idle.prepare_wait();
+            if ((task = find_task(self)))
+            {
+                idle.cancel_wait();
+                run(task);
+                continue;
+            }
+            if (stop.load(std::memory_order_seq_cst)) // Stopping and nothing left anywhere
+            {
+                idle.cancel_wait();
+                break;
+            }
+            idle.wait(key);
+        }
+        SlabAllocator::unbind_thread();
+        current = nullptr;
+    }
+
+    Task* find_task(Worker* self)
+    {
+        if (Task* task = self->deque.pop()) return task;
+        if (Task* task = take_injected(self)) return task;
+
+        // Steal the oldest task of a random victim
+        std::size_t n = workers.size();
+        std::size_t start = self->rng() % n;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            Worker* victim = workers[(start + i) % n].get();
+            if (victim == self) continue;
+            if (Task* task = victim->deque.steal()) return task;
+        }
+        return nullptr;
+    }
+
+    // Returns one injected task and moves a batch of others to the worker's deque
+    Task* take_injected(Worker* self)
+    {
+        if (injected_count.load(std::memory_order_relaxed) == 0) return nullptr;
+
+        Task* task = nullptr;
+        std::size_t moved = 0;
+        {
+            std::lock_guard<std::mutex> lock(inject_mutex);
+            if (!injected_head) return nullptr;
+
+            task = injected_head;
+            injected_head = task->next;
+            for (; moved + 1 < inject_batch && injected_head; ++moved)
+            {
+                Task* next = injected_head->next;
+                self->deque.push(injected_head);
+                injected_head = next;
+            }
+            if (!injected_head) injected_tail = nullptr;
+            injected_count.store(injected_count.load(std::memory_order_relaxed) - moved - 1, std::memory_order_relaxed);
+        }
+        if (moved) idle.notify_one(); // Let a parked worker steal part of the batch
+        return task;
+    }
+
+    void run(Task* task)
+    {
+        struct Release
+        {
+            BasicThreadPool* pool;
+            Task* task;
+
+            ~Release()
+            {
+                task->~Task();
+                pool->slab->deallocate(task, sizeof(Task));
+            }
+        } release{this, task};
+        task->fn();
+    }
+
+    const bool slab_closures;
+    // Task nodes, closures too large for the inline buffer and future states, with one
+    // cache per worker. Shared with the futures, which may outlive the pool
+    std::shared_ptr<SlabAllocator> slab;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stop{false};
+
+    // Tasks enqueued by threads that are not workers of this pool
+    alignas(64) std::mutex inject_mutex;
+    Task* injected_head = nullptr; // Linked through Task::next, so enqueueing allocates nothing
+    Task* injected_tail = nullptr;
+    std::atomic<std::size_t> injected_count{0};
+
+    EventCount idle;
+};
+
+using ThreadPool = BasicThreadPool<>;
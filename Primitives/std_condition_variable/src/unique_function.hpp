@@ -0,0 +1,172 @@
+/*
+
+Move-only type-erased callable with a configurable inline buffer
+
+std::function must be copyable, so a task type built on it cannot hold a
+move-only capture (a std::unique_ptr, a std::promise), and a capture larger
+than the library's small buffer (16 bytes with libstdc++) is allocated with new.
+UniqueFunction<R(Args...), InlineSize> is move-only and stores callables of up to
+InlineSize bytes in place:
+
+- A callable that fits, is aligned for std::max_align_t at most and is
+  nothrow-movable lives in the buffer; moving the UniqueFunction moves it.
+- A larger one is allocated from the SlabAllocator passed to the constructor
+  (slab_allocator.hpp), or with new when there is none or it is too large for
+  the slab. Moving the UniqueFunction then only moves a pointer.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "slab_allocator.hpp"
+
+template <typename Signature, std::size_t InlineSize = 64>
+class UniqueFunction;
+
+template <typename R, typename... Args, std::size_t InlineSize>
+class UniqueFunction<R(Args...), InlineSize>
+{
+    struct Remote
+    {
+        void* object;
+        SlabAllocator* slab; // nullptr: allocated with new
+    };
+
+    static_assert(InlineSize >= sizeof(Remote), "the buffer must at least hold a pointer to a remote callable");
+
+public:
+    static constexpr std::size_t inline_size = InlineSize;
+
+    // Callables that are stored in place, without any allocation
+    template <typename Fn>
+    static constexpr bool fits_inline = sizeof(Fn) <= InlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+                                        std::is_nothrow_move_constructible_v<Fn>;
+
+    UniqueFunction() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, UniqueFunction>>>
+    UniqueFunction(F&& f, SlabAllocator* slab = nullptr)
+    {
+        using Fn = std::decay_t<F>;
+        if constexpr (fits_inline<Fn>)
+        {
+            ::new (static_cast<void*>(storage)) Fn(std::forward<F>(f));
+            ops = &inline_ops<Fn>;
+        }
+        else
+        {
+            if (alignof(Fn) > alignof(std::max_align_t) || sizeof(Fn) > SlabAllocator::max_block) slab = nullptr;
+
+            Remote remote{nullptr, slab};
+            if (slab)
+            {
+                remote.object = slab->allocate(sizeof(Fn));
+                try
+                {
+                    ::new (remote.object) Fn(std::forward<F>(f));
+                }
+                catch (...)
+                {
+                    slab->deallocate(remote.object, sizeof(Fn));
+                    throw;
+                }
+            }
+            else
+            {
+                remote.object = new Fn(std::forward<F>(f));
+            }
+            ::new (static_cast<void*>(storage)) Remote(remote);
+            ops = &remote_ops<Fn>;
+        }
+    }
+
+    UniqueFunction(UniqueFunction&& other) noexcept { take(other); }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    UniqueFunction(const UniqueFunction&) = delete;
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    ~UniqueFunction() { reset(); }
+
+    explicit operator bool() const { return ops != nullptr; }
+
+    R operator()(Args... args) { return ops->call(storage, std::forward<Args>(args)...); }
+
+private:
+    struct Ops
+    {
+        R (*call)(void*, Args&&...);
+        void (*move)(void* to, void* from); // move-constructs into `to` and destroys `from`
+        void (*destroy)(void*);
+    };
+
+    template <typename T>
+    static T& object(void* p) { return *std::launder(static_cast<T*>(p)); }
+
+    template <typename Fn>
+    static constexpr Ops inline_ops = {
+        [](void* p, Args&&... args) -> R { return std::invoke(object<Fn>(p), std::forward<Args>(args)...); },
+        [](void* to, void* from)
+        {
+            ::new (to) Fn(std::move(object<Fn>(from)));
+            object<Fn>(from).~Fn();
+        },
+        [](void* p) { object<Fn>(p).~Fn(); }};
+
+    template <typename Fn>
+    static constexpr Ops remote_ops = {
+        [](void* p, Args&&... args) -> R
+        {
+            return std::invoke(*static_cast<Fn*>(object<Remote>(p).object), std::forward<Args>(args)...);
+        },
+        [](void* to, void* from) { ::new (to) Remote(object<Remote>(from)); },
+        [](void* p)
+        {
+            Remote& remote = object<Remote>(p);
+            Fn* fn = static_cast<Fn*>(remote.object);
+            if (remote.slab)
+            {
+                fn->~Fn();
+                remote.slab->deallocate(fn, sizeof(Fn));
+            }
+            else
+            {
+                delete fn;
+            }
+        }};
+
+    void take(UniqueFunction& other) noexcept
+    {
+        if (other.ops)
+        {
+            other.ops->move(storage, other.storage);
+            ops = std::exchange(other.ops, nullptr);
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (ops)
+        {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[InlineSize];
+    const Ops* ops = nullptr;
+};